@@ -1,9 +1,31 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
-#include <regex>
+#include <string_view>
+#include <optional>
+#include <bit>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace {
+    enum TokenType {
+        Do,
+        Dont,
+        Mul,
+    };
+
+    struct Token {
+        TokenType type;
+        std::size_t length;
+        int product = 0;
+    };
+
+    using CandidateMask = std::uint32_t;
+    constexpr auto block_size = std::size_t{32};
+
     [[nodiscard]] auto read_corrupted_memory_from_file(const std::string& file_path) -> std::string {
         auto file = std::ifstream(file_path);
 
@@ -12,36 +34,125 @@ namespace {
         return buffer.str();
     }
 
-    [[nodiscard]] auto extract_mul_parameters(const std::string& mul_func) -> std::pair<int, int> {
-        constexpr auto parameters_index = 4;
-        constexpr auto delimiter = ',';
-        const auto delimiter_index = mul_func.find_first_of(delimiter);
-        const auto arg1_string = mul_func.substr(parameters_index, delimiter_index);
-        const auto arg2_string = mul_func.substr(delimiter_index + 1);
+    [[nodiscard]] constexpr auto is_token_start(const char c) noexcept -> bool {
+        return c == 'm' or c == 'd';
+    }
 
-        const auto arg1 = std::stoi(arg1_string);
-        const auto arg2 = std::stoi(arg2_string);
-        return {arg1, arg2};
+    // Flags every byte of a 32 byte block that could begin a token.
+    [[nodiscard]] auto candidate_mask(const char* block) noexcept -> CandidateMask {
+#if defined(__AVX2__)
+        const auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        const auto m_matches = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('m'));
+        const auto d_matches = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('d'));
+        return static_cast<CandidateMask>(_mm256_movemask_epi8(_mm256_or_si256(m_matches, d_matches)));
+#elif defined(__SSE2__)
+        const auto half_mask = [](const char* half) {
+            const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(half));
+            const auto m_matches = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('m'));
+            const auto d_matches = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('d'));
+            return static_cast<CandidateMask>(_mm_movemask_epi8(_mm_or_si128(m_matches, d_matches)));
+        };
+        return half_mask(block) | half_mask(block + block_size / 2) << block_size / 2;
+#else
+        CandidateMask mask = 0;
+        for (std::size_t i = 0; i < block_size; ++i) {
+            mask |= static_cast<CandidateMask>(is_token_start(block[i])) << i;
+        }
+        return mask;
+#endif
     }
 
-    [[nodiscard]] auto process_corrupted_mul(const std::string& memory) -> int {
-        const auto multiply_pattern = std::regex{R"((do\(\)|don't\(\)|mul\([0-9]{1,3},[0-9]{1,3}\)))"};
-        const auto do_func = std::string{"do()"};
-        const auto dont_func = std::string{"don't()"};
+    // Reads 1-3 digits followed by the given terminator, advancing pos past both.
+    [[nodiscard]] auto read_mul_parameter(
+        const std::string_view memory,
+        std::size_t& pos,
+        const char terminator
+    ) noexcept -> std::optional<int> {
+        constexpr auto max_digits = std::size_t{3};
+        auto value = 0;
+        auto num_digits = std::size_t{0};
+        while (pos < memory.size() and num_digits < max_digits and memory[pos] >= '0' and memory[pos] <= '9') {
+            value = value * 10 + (memory[pos] - '0');
+            ++num_digits;
+            ++pos;
+        }
 
+        if (num_digits == 0 or pos >= memory.size() or memory[pos] != terminator) {
+            return std::nullopt;
+        }
+        ++pos;
+        return value;
+    }
+
+    [[nodiscard]] auto match_token(const std::string_view memory, const std::size_t pos) noexcept -> std::optional<Token> {
+        const auto remaining = memory.substr(pos);
+        if (constexpr auto do_func = std::string_view{"do()"}; remaining.starts_with(do_func)) {
+            return Token{Do, do_func.size()};
+        }
+        if (constexpr auto dont_func = std::string_view{"don't()"}; remaining.starts_with(dont_func)) {
+            return Token{Dont, dont_func.size()};
+        }
+
+        constexpr auto mul_prefix = std::string_view{"mul("};
+        if (not remaining.starts_with(mul_prefix)) {
+            return std::nullopt;
+        }
+
+        auto end = pos + mul_prefix.size();
+        const auto arg1 = read_mul_parameter(memory, end, ',');
+        if (not arg1) {
+            return std::nullopt;
+        }
+        const auto arg2 = read_mul_parameter(memory, end, ')');
+        if (not arg2) {
+            return std::nullopt;
+        }
+
+        return Token{Mul, end - pos, *arg1 * *arg2};
+    }
+
+    [[nodiscard]] auto process_corrupted_mul(const std::string& memory) -> int {
         auto enabled = true;
         auto product_sum = 0;
-        const auto first_match_it = std::sregex_iterator(memory.begin(), memory.end(), multiply_pattern);
-        for (auto it = first_match_it; it != std::sregex_iterator(); ++it) {
-            const auto func_as_str = it->str();
-
-            if (func_as_str == do_func) {
-                enabled = true;
-            } else if (func_as_str == dont_func) {
-                enabled = false;
-            } else if (enabled) {
-                const auto [arg1, arg2] = extract_mul_parameters(func_as_str);
-                product_sum += arg1 * arg2;
+        auto next_free_pos = std::size_t{0};
+
+        const auto process_candidate = [&](const std::size_t pos) {
+            if (pos < next_free_pos) {
+                return;
+            }
+
+            const auto token = match_token(memory, pos);
+            if (not token) {
+                return;
+            }
+
+            next_free_pos = pos + token->length;
+            switch (token->type) {
+                case Do:
+                    enabled = true;
+                    break;
+                case Dont:
+                    enabled = false;
+                    break;
+                case Mul:
+                    if (enabled) {
+                        product_sum += token->product;
+                    }
+                    break;
+            }
+        };
+
+        // Only run the full matcher where the prefilter found an 'm' or 'd'
+        auto block_start = std::size_t{0};
+        for (; block_start + block_size <= memory.size(); block_start += block_size) {
+            for (auto mask = candidate_mask(memory.data() + block_start); mask != 0; mask &= mask - 1) {
+                process_candidate(block_start + std::countr_zero(mask));
+            }
+        }
+
+        for (auto pos = block_start; pos < memory.size(); ++pos) {
+            if (is_token_start(memory[pos])) {
+                process_candidate(pos);
             }
         }
 
@@ -57,4 +168,4 @@ auto main() -> int {
 
     std::cout << result << '\n';
     return 0;
-}
\ No newline at end of file
+}
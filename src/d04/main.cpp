@@ -2,41 +2,118 @@
 #include <fstream>
 #include <algorithm>
 #include <array>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <bit>
+#include <cstdint>
+#include <future>
+#include <thread>
 
 namespace {
-    constexpr auto height = std::size_t{140};
-    constexpr auto width = std::size_t{140};
-    using WordPuzzle = std::array<std::array<char, width>, height>;
+    using WordPuzzle = std::vector<std::string>;
+    using PlaneWord = std::uint64_t;
+    constexpr auto bits_per_word = std::ptrdiff_t{64};
+
+    // One bitset row per letter of interest, bit x of row y set when puzzle[y][x] is that letter
+    struct LetterPlanes {
+        std::string letters;
+        std::size_t first_row = 0;
+        std::size_t height = 0;
+        std::size_t width = 0;
+        std::size_t words_per_row = 0;
+        std::vector<std::vector<PlaneWord>> planes;
+    };
 
     [[nodiscard]] auto read_word_puzzle_from_file(const std::string& file_path) -> WordPuzzle {
         auto word_puzzle = WordPuzzle{};
 
         auto file = std::fstream {file_path};
-        auto i = 0;
         for (std::string line; std::getline(file, line);) {
-            auto j = 0;
-            for (const char c : line) {
-                word_puzzle[i][j++] = c;
+            if (line.empty()) {
+                continue;
             }
-            ++i;
+            word_puzzle.push_back(line);
         }
         return word_puzzle;
     }
 
-    [[nodiscard]] auto is_invalid_coordinate(const int y, const int x) noexcept -> bool {
-        return y >= height or x >= width or y < 0 or x < 0;
+    // Builds the planes for puzzle rows [first_row, last_row), which may be a band of a larger puzzle
+    [[nodiscard]] auto build_letter_planes(
+        const WordPuzzle& puzzle,
+        const std::string_view letters,
+        const std::size_t first_row,
+        const std::size_t last_row
+    ) -> LetterPlanes {
+        auto letter_planes = LetterPlanes{};
+        letter_planes.letters = letters;
+        letter_planes.first_row = first_row;
+        letter_planes.height = last_row - first_row;
+        for (auto y = first_row; y < last_row; ++y) {
+            letter_planes.width = std::max(letter_planes.width, puzzle[y].size());
+        }
+        letter_planes.words_per_row = (letter_planes.width + bits_per_word - 1) / bits_per_word;
+
+        const auto plane_size = letter_planes.height * letter_planes.words_per_row;
+        letter_planes.planes.assign(letters.size(), std::vector<PlaneWord>(plane_size));
+        for (auto y = first_row; y < last_row; ++y) {
+            const auto row_offset = (y - first_row) * letter_planes.words_per_row;
+            for (std::size_t x = 0; x < puzzle[y].size(); ++x) {
+                const auto letter_index = letters.find(puzzle[y][x]);
+                if (letter_index == std::string_view::npos) {
+                    continue;
+                }
+
+                auto& word = letter_planes.planes[letter_index][row_offset + x / bits_per_word];
+                word |= PlaneWord{1} << x % bits_per_word;
+            }
+        }
+        return letter_planes;
     }
 
-    [[nodiscard]] auto num_adjacent_words(
-        const WordPuzzle& puzzle,
-        const std::size_t y_pos,
-        const std::size_t x_pos
-    ) -> unsigned int {
-        const auto word_to_find = std::string{"XMAS"};
-        if (puzzle[y_pos][x_pos] != word_to_find[0]) {
-            return 0;
+    // Returns the plane row for a letter, or nullptr if the row is outside the planes or the letter is untracked
+    [[nodiscard]] auto plane_row(
+        const LetterPlanes& letter_planes,
+        const char letter,
+        const std::ptrdiff_t y
+    ) noexcept -> const PlaneWord* {
+        const auto letter_index = letter_planes.letters.find(letter);
+        const auto plane_y = y - static_cast<std::ptrdiff_t>(letter_planes.first_row);
+        if (letter_index == std::string::npos or plane_y < 0 or plane_y >= static_cast<std::ptrdiff_t>(letter_planes.height)) {
+            return nullptr;
         }
+        return letter_planes.planes[letter_index].data() + plane_y * letter_planes.words_per_row;
+    }
 
+    // Word w of the row viewed from `shift` cells to the right, i.e. bit i holds cell 64w + i + shift
+    [[nodiscard]] auto shifted_word(
+        const PlaneWord* row,
+        const std::size_t words_per_row,
+        const std::size_t word_index,
+        const std::ptrdiff_t shift
+    ) noexcept -> PlaneWord {
+        const auto fetch = [row, words_per_row](const std::ptrdiff_t index) -> PlaneWord {
+            if (index < 0 or index >= static_cast<std::ptrdiff_t>(words_per_row)) {
+                return 0;
+            }
+            return row[index];
+        };
+
+        const auto first_bit = static_cast<std::ptrdiff_t>(word_index) * bits_per_word + shift;
+        const auto source_index = first_bit >> 6;
+        const auto offset = first_bit & (bits_per_word - 1);
+        if (offset == 0) {
+            return fetch(source_index);
+        }
+        return fetch(source_index) >> offset | fetch(source_index + 1) << (bits_per_word - offset);
+    }
+
+    [[nodiscard]] auto count_words_in_rows(
+        const LetterPlanes& letter_planes,
+        const std::string_view word_to_find,
+        const std::size_t first_row,
+        const std::size_t last_row
+    ) -> unsigned long {
         constexpr std::pair<int, int> directions[8] = {
             {-1, 0},
             {0, 1},
@@ -48,73 +125,260 @@ namespace {
             {1, -1}
         };
 
-        const auto x = static_cast<int>(x_pos);
-        const auto y = static_cast<int>(y_pos);
-        const auto word_length = word_to_find.size();
-        unsigned int num_adjacent = 0;
-
-        for (const auto& direction : directions) {
-            auto num_letters = 1;
-            for (auto i = 1; i < word_length; ++i) {
-                const auto [y_diff, x_diff] = direction;
-                const auto new_y  = y + y_diff * i;
-                const auto new_x = x + x_diff * i;
+        unsigned long words_found = 0;
+        auto letter_rows = std::vector<const PlaneWord*>(word_to_find.size());
+        for (auto y = first_row; y < last_row; ++y) {
+            for (const auto& [y_diff, x_diff] : directions) {
+                auto word_fits = true;
+                for (std::size_t i = 0; i < word_to_find.size(); ++i) {
+                    const auto offset = static_cast<std::ptrdiff_t>(i);
+                    const auto letter_y = static_cast<std::ptrdiff_t>(y) + y_diff * offset;
+                    letter_rows[i] = plane_row(letter_planes, word_to_find[i], letter_y);
+                    word_fits = word_fits and letter_rows[i] != nullptr;
+                }
+                if (not word_fits) {
+                    continue;
+                }
 
-                if (is_invalid_coordinate(new_y, new_x) or word_to_find[i] != puzzle[new_y][new_x]) {
-                    break;
+                for (std::size_t w = 0; w < letter_planes.words_per_row; ++w) {
+                    auto matches = ~PlaneWord{0};
+                    for (std::size_t i = 0; i < word_to_find.size() and matches != 0; ++i) {
+                        const auto shift = x_diff * static_cast<std::ptrdiff_t>(i);
+                        matches &= shifted_word(letter_rows[i], letter_planes.words_per_row, w, shift);
+                    }
+                    words_found += std::popcount(matches);
                 }
-                ++num_letters;
             }
-            if (num_letters == word_length) {
-                ++num_adjacent;
+        }
+        return words_found;
+    }
+
+    [[nodiscard]] auto count_crosses_in_rows(
+        const LetterPlanes& letter_planes,
+        const std::size_t first_row,
+        const std::size_t last_row
+    ) -> unsigned long {
+        constexpr auto center_char = 'A';
+        constexpr auto start_char = 'M';
+        constexpr auto end_char = 'S';
+
+        unsigned long crosses_found = 0;
+        for (auto y = first_row; y < last_row; ++y) {
+            const auto signed_y = static_cast<std::ptrdiff_t>(y);
+            const auto center_row = plane_row(letter_planes, center_char, signed_y);
+            const auto upper_start = plane_row(letter_planes, start_char, signed_y - 1);
+            const auto upper_end = plane_row(letter_planes, end_char, signed_y - 1);
+            const auto lower_start = plane_row(letter_planes, start_char, signed_y + 1);
+            const auto lower_end = plane_row(letter_planes, end_char, signed_y + 1);
+            if (not center_row or not upper_start or not upper_end or not lower_start or not lower_end) {
+                continue;
+            }
+
+            const auto words_per_row = letter_planes.words_per_row;
+            for (std::size_t w = 0; w < words_per_row; ++w) {
+                const auto at = [words_per_row, w](const PlaneWord* row, const std::ptrdiff_t shift) {
+                    return shifted_word(row, words_per_row, w, shift);
+                };
+
+                // Each diagonal must read 'MAS' in either direction
+                const auto falling_diagonal = (at(upper_start, -1) & at(lower_end, 1))
+                    | (at(upper_end, -1) & at(lower_start, 1));
+                const auto rising_diagonal = (at(upper_start, 1) & at(lower_end, -1))
+                    | (at(upper_end, 1) & at(lower_start, -1));
+                crosses_found += std::popcount(center_row[w] & falling_diagonal & rising_diagonal);
+            }
+        }
+        return crosses_found;
+    }
+
+    // Splits the puzzle into horizontal bands scanned in parallel. Each band owns the matches starting (or centred)
+    // in its rows and reads a halo of neighbouring rows, so boundary matches are counted exactly once.
+    [[nodiscard]] auto count_matches_in_bands(
+        const WordPuzzle& puzzle,
+        const std::string_view word_to_find
+    ) -> std::pair<unsigned long, unsigned long> {
+        constexpr auto min_band_height = std::size_t{256};
+        const auto halo_rows = std::max(word_to_find.size(), std::size_t{2}) - 1;
+        const auto num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        const auto band_height = std::max((puzzle.size() + num_threads - 1) / num_threads, min_band_height);
+
+        std::vector<std::future<std::pair<unsigned long, unsigned long>>> band_counts;
+        for (std::size_t first_row = 0; first_row < puzzle.size(); first_row += band_height) {
+            const auto last_row = std::min(first_row + band_height, puzzle.size());
+            band_counts.push_back(std::async(std::launch::async, [&puzzle, word_to_find, halo_rows, first_row, last_row] {
+                const auto halo_first = first_row - std::min(first_row, halo_rows);
+                const auto halo_last = std::min(last_row + halo_rows, puzzle.size());
+                const auto letter_planes = build_letter_planes(puzzle, word_to_find, halo_first, halo_last);
+
+                return std::pair{
+                    count_words_in_rows(letter_planes, word_to_find, first_row, last_row),
+                    count_crosses_in_rows(letter_planes, first_row, last_row)
+                };
+            }));
+        }
+
+        unsigned long words_found = 0;
+        unsigned long crosses_found = 0;
+        for (auto& band_count : band_counts) {
+            const auto [band_words, band_crosses] = band_count.get();
+            words_found += band_words;
+            crosses_found += band_crosses;
+        }
+        return {words_found, crosses_found};
+    }
+
+    // Aho-Corasick automaton over a dictionary and its reversed words, with failure links folded into the
+    // transition table so every character costs a single lookup
+    struct WordAutomaton {
+        static constexpr auto no_letter = std::uint16_t{0xFFFF};
+        static constexpr auto root = std::uint32_t{0};
+
+        std::array<std::uint16_t, 256> letter_index{};
+        std::size_t alphabet_size = 0;
+        std::vector<std::uint32_t> transitions;
+        std::vector<std::uint32_t> fail;
+        std::vector<std::uint32_t> breadth_first_order;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> word_states;
+    };
+
+    [[nodiscard]] auto read_dictionary_from_file(const std::string& file_path) -> std::vector<std::string> {
+        std::vector<std::string> dictionary;
+
+        auto file = std::fstream {file_path};
+        for (std::string word; std::getline(file, word);) {
+            if (not word.empty()) {
+                dictionary.push_back(word);
             }
         }
-        return num_adjacent;
+        return dictionary;
     }
 
-    [[nodiscard]] auto is_cross(const WordPuzzle& puzzle, const std::size_t y_pos, const std::size_t x_pos) -> bool {
-        if (constexpr auto center_char = 'A'; puzzle[y_pos][x_pos] != center_char) {
-            return false;
+    [[nodiscard]] auto build_word_automaton(const std::vector<std::string>& dictionary) -> WordAutomaton {
+        auto automaton = WordAutomaton{};
+        automaton.letter_index.fill(WordAutomaton::no_letter);
+        for (const auto& word : dictionary) {
+            for (const auto c : word) {
+                if (auto& index = automaton.letter_index[static_cast<unsigned char>(c)]; index == WordAutomaton::no_letter) {
+                    index = static_cast<std::uint16_t>(automaton.alphabet_size++);
+                }
+            }
         }
 
-        using CoordsPair = std::pair<std::pair<int, int>, std::pair<int, int>>;
-        constexpr CoordsPair corner_pairs[2] = {
-            {
-		{1, 1},
-		{-1, -1},
-            },
-            {
-                {-1, 1},
-		{1, -1}
+        const auto alphabet_size = automaton.alphabet_size;
+        auto& transitions = automaton.transitions;
+        transitions.assign(alphabet_size, WordAutomaton::root);
+        auto num_states = std::uint32_t{1};
+
+        // Build the trie, using the root as the 'missing' marker since no edge leads back to it
+        const auto insert = [&](const auto first, const auto last) {
+            auto state = WordAutomaton::root;
+            for (auto it = first; it != last; ++it) {
+                const auto letter = automaton.letter_index[static_cast<unsigned char>(*it)];
+                auto next = transitions[state * alphabet_size + letter];
+                if (next == WordAutomaton::root) {
+                    next = num_states++;
+                    transitions[state * alphabet_size + letter] = next;
+                    transitions.resize(num_states * alphabet_size, WordAutomaton::root);
+                }
+                state = next;
             }
+            return state;
         };
 
-        const auto y = static_cast<int>(y_pos);
-        const auto x = static_cast<int>(x_pos);
-        const auto is_valid_pair = [puzzle, x, y](const CoordsPair& coords_pair) {
-            const auto [y_diff1, x_diff1] = coords_pair.first;
-            const auto [y_diff2, x_diff2] = coords_pair.second;
+        for (const auto& word : dictionary) {
+            const auto forward_state = insert(word.begin(), word.end());
+            const auto reverse_state = insert(word.rbegin(), word.rend());
+            automaton.word_states.emplace_back(forward_state, reverse_state);
+        }
 
-            const auto new_x1 = x + x_diff1;
-            const auto new_y1 = y + y_diff1;
-            const auto new_x2 = x + x_diff2;
-            const auto new_y2 = y + y_diff2;
+        // Resolve failure links breadth first so missing edges can borrow from the failure state
+        automaton.fail.assign(num_states, WordAutomaton::root);
+        auto& order = automaton.breadth_first_order;
+        order.reserve(num_states);
+        for (std::size_t letter = 0; letter < alphabet_size; ++letter) {
+            if (const auto child = transitions[letter]; child != WordAutomaton::root) {
+                order.push_back(child);
+            }
+        }
+
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            const auto state = order[i];
+            const auto fail_state = automaton.fail[state];
+            for (std::size_t letter = 0; letter < alphabet_size; ++letter) {
+                auto& next = transitions[state * alphabet_size + letter];
+                const auto fallback = transitions[fail_state * alphabet_size + letter];
+                if (next == WordAutomaton::root) {
+                    next = fallback;
+                    continue;
+                }
 
-            if (is_invalid_coordinate(new_y1, new_x1) or is_invalid_coordinate(new_y2, new_x2)) {
-                return false;
+                automaton.fail[next] = fallback;
+                order.push_back(next);
             }
+        }
+
+        return automaton;
+    }
+
+    // Counts every dictionary word along rows, columns and both diagonal families in both reading directions
+    [[nodiscard]] auto count_dictionary_words(
+        const WordPuzzle& puzzle,
+        const WordAutomaton& automaton
+    ) -> std::vector<unsigned long> {
+        const auto height = static_cast<std::ptrdiff_t>(puzzle.size());
+        auto width = std::ptrdiff_t{0};
+        for (const auto& row : puzzle) {
+            width = std::max(width, static_cast<std::ptrdiff_t>(row.size()));
+        }
 
-            const auto is_valid_diagonal = [puzzle](const int y1, const int x1, const int y2, const int x2) {
-                constexpr auto start_char = 'M';
-                constexpr auto end_char = 'S';
-                return puzzle[y1][x1] == start_char and puzzle[y2][x2] == end_char;
-            };
+        const auto cell = [&puzzle, height](const std::ptrdiff_t y, const std::ptrdiff_t x) -> char {
+            if (y < 0 or y >= height or x < 0 or x >= static_cast<std::ptrdiff_t>(puzzle[y].size())) {
+                return '\0';
+            }
+            return puzzle[y][x];
+        };
 
-            return is_valid_diagonal(new_y1, new_x1, new_y2, new_x2)
-                or is_valid_diagonal(new_y2, new_x2, new_y1, new_x1);
+        std::vector<unsigned long> state_hits(automaton.fail.size());
+        const auto scan_line = [&](std::ptrdiff_t y, std::ptrdiff_t x, const std::ptrdiff_t y_diff, const std::ptrdiff_t x_diff) {
+            auto state = WordAutomaton::root;
+            for (; y >= 0 and y < height and x >= 0 and x < width; y += y_diff, x += x_diff) {
+                const auto letter = automaton.letter_index[static_cast<unsigned char>(cell(y, x))];
+                if (letter == WordAutomaton::no_letter) {
+                    state = WordAutomaton::root;
+                    continue;
+                }
+                state = automaton.transitions[state * automaton.alphabet_size + letter];
+                ++state_hits[state];
+            }
         };
 
-        return std::ranges::all_of(corner_pairs, is_valid_pair);
+        for (std::ptrdiff_t y = 0; y < height; ++y) {
+            scan_line(y, 0, 0, 1);
+            scan_line(y, 0, 1, 1);
+            scan_line(y, width - 1, 1, -1);
+        }
+        for (std::ptrdiff_t x = 0; x < width; ++x) {
+            scan_line(0, x, 1, 0);
+            if (x > 0) {
+                scan_line(0, x, 1, 1);
+            }
+            if (x < width - 1) {
+                scan_line(0, x, 1, -1);
+            }
+        }
+
+        // A hit on a state is also a hit on every suffix state reachable through failure links
+        const auto& order = automaton.breadth_first_order;
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            state_hits[automaton.fail[*it]] += state_hits[*it];
+        }
+
+        std::vector<unsigned long> word_counts;
+        word_counts.reserve(automaton.word_states.size());
+        for (const auto& [forward_state, reverse_state] : automaton.word_states) {
+            word_counts.push_back(state_hits[forward_state] + state_hits[reverse_state]);
+        }
+        return word_counts;
     }
 }
 
@@ -122,19 +386,19 @@ auto main() -> int {
     const auto file_path = std::string{"input.txt"};
     const auto word_puzzle = read_word_puzzle_from_file(file_path);
 
-    unsigned int words_found = 0;
-    unsigned int crosses_found = 0;
-    for (std::size_t y = 0; y < word_puzzle.size(); ++y) {
-        for (std::size_t x = 0; x < word_puzzle[y].size(); ++x) {
-            words_found += num_adjacent_words(word_puzzle, y, x);
-
-            if (is_cross(word_puzzle, y, x)) {
-                ++crosses_found;
-            }
-        }
-    }
+    const auto word_to_find = std::string_view{"XMAS"};
+    const auto [words_found, crosses_found] = count_matches_in_bands(word_puzzle, word_to_find);
 
     std::cout << "Times 'XMAS' found: " << words_found << '\n';
     std::cout << "Times 'X-MAS' found: " << crosses_found << '\n';
+
+    const auto dictionary_path = std::string{"dictionary.txt"};
+    if (const auto dictionary = read_dictionary_from_file(dictionary_path); not dictionary.empty()) {
+        const auto automaton = build_word_automaton(dictionary);
+        const auto word_counts = count_dictionary_words(word_puzzle, automaton);
+        for (std::size_t i = 0; i < dictionary.size(); ++i) {
+            std::cout << "Times '" << dictionary[i] << "' found: " << word_counts[i] << '\n';
+        }
+    }
     return 0;
 }
@@ -1,108 +1,123 @@
 #include <iostream>
 #include <vector>
-#include <unordered_map>
-#include <unordered_set>
 #include <fstream>
 #include <sstream>
-#include <algorithm>
+#include <charconv>
+#include <span>
+
+#include "rule_index.h"
 
 namespace {
-    using PrintingRules = std::unordered_map<std::string, std::unordered_set<std::string>>;
-    using Instructions = std::vector<std::vector<std::string>>;
+    // Every instruction's pages stored back to back, instruction i spanning [offsets[i], offsets[i + 1])
+    struct Instructions {
+        std::vector<PageId> pages;
+        std::vector<std::size_t> offsets{0};
+    };
+
+    struct PageSums {
+        int middle_page_sum = 0;
+        int corrected_sum = 0;
+    };
+
+    [[nodiscard]] auto parse_page(const std::string_view page) -> int {
+        auto page_number = 0;
+        std::from_chars(page.data(), page.data() + page.size(), page_number);
+        return page_number;
+    }
 
-    [[nodiscard]] auto read_printing_rules(std::fstream& file) -> PrintingRules {
-        PrintingRules rules;
+    [[nodiscard]] auto parse_rule(const std::string_view line) -> std::pair<int, int> {
+        constexpr auto delimiter = '|';
+        const auto delimiter_index = line.find(delimiter);
+        return {parse_page(line.substr(0, delimiter_index)), parse_page(line.substr(delimiter_index + 1))};
+    }
 
+    auto read_printing_rules(std::fstream& file, RuleIndex& rules) -> void {
         for (std::string line; std::getline(file, line);) {
             if (line.empty()) {
                 break;
             }
 
-            constexpr auto delimiter = '|';
-            auto line_stream = std::stringstream(line);
-            std::string first_page, second_page;
-            std::getline(line_stream, first_page, delimiter);
-            std::getline(line_stream, second_page);
-
-            if (rules.contains(first_page)) {
-                rules.at(first_page).insert(second_page);
-            } else {
-                const auto rule_set = std::unordered_set{second_page};
-                rules.emplace(first_page, rule_set);
-            }
+            const auto [first_page, second_page] = parse_rule(line);
+            rules.add_rule(first_page, second_page);
         }
+    }
 
-        return rules;
+    auto read_printing_instruction(const std::string& line, RuleIndex& rules, Instructions& instructions) -> void {
+        constexpr auto delimiter = ',';
+        auto line_stream = std::stringstream(line);
+        for (std::string page; std::getline(line_stream, page, delimiter);) {
+            instructions.pages.push_back(rules.intern_page(parse_page(page)));
+        }
+        instructions.offsets.push_back(instructions.pages.size());
     }
 
-    [[nodiscard]] auto read_printing_instructions(std::fstream& file) -> Instructions {
-        Instructions instructions;
-        for (std::string line; std::getline(file, line);) {
-            std::vector<std::string> instruction;
+    // Validates a batch against the current rules, correcting only the invalid instructions
+    auto process_instructions(Instructions& instructions, RuleIndex& rules, PageSums& sums) -> void {
+        const auto& offsets = instructions.offsets;
+        for (std::size_t i = 0; i + 1 < offsets.size(); ++i) {
+            const auto instruction = std::span{instructions.pages}.subspan(offsets[i], offsets[i + 1] - offsets[i]);
+            if (instruction.empty()) {
+                continue;
+            }
 
-            constexpr auto delimiter = ',';
-            auto line_stream = std::stringstream(line);
-            for (std::string page; std::getline(line_stream, page, delimiter);) {
-                instruction.push_back(page);
+            if (rules.is_valid_update(instruction)) {
+                sums.middle_page_sum += rules.page_number(instruction[instruction.size() / 2]);
+                continue;
+            }
+
+            rules.correct_update(instruction);
+            sums.corrected_sum += rules.page_number(instruction[instruction.size() / 2]);
+            if (rules.is_valid_update(instruction)) {
+                continue;
+            }
+
+            for (const auto& cycle : rules.find_rule_cycles(instruction)) {
+                std::cout << "Rule cycle between pages:";
+                for (const auto page : cycle) {
+                    std::cout << ' ' << page;
+                }
+                std::cout << '\n';
             }
-            instructions.push_back(instruction);
         }
 
-        return instructions;
+        instructions = Instructions{};
     }
 
-    [[nodiscard]] auto read_printing_file(
-        const std::string& file_path
-    ) -> std::pair<PrintingRules, Instructions> {
+    // After the initial rules, lines of the form 'a|b' add a rule and '-a|b' remove one. Instructions between rule
+    // changes form a batch checked against the rules in force when it arrived.
+    [[nodiscard]] auto process_printing_file(const std::string& file_path) -> PageSums {
         auto file = std::fstream(file_path);
-        const auto rules = read_printing_rules(file);
-        const auto instructions = read_printing_instructions(file);
-
-        return {rules, instructions};
-    }
+        auto rules = RuleIndex{};
+        read_printing_rules(file, rules);
 
-    [[nodiscard]] auto process_instruction(
-        std::vector<std::string>& instruction,
-        const PrintingRules& rules,
-        const bool correction
-    ) -> int {
-        std::vector<std::vector<std::string>::iterator> read_pages;
-
-        for (auto page_it = instruction.begin(); page_it != instruction.end(); ++page_it) {
-            if (rules.contains(*page_it)) {
-                const auto& page_rules = rules.at(*page_it);
-
-                for (const auto& read_it : read_pages) {
-                    if (const auto has_rule = page_rules.contains(*read_it); has_rule and correction) {
-                        std::iter_swap(read_it, page_it);
-                    } else if (has_rule) {
-                        return 0;
-                    }
-                }
+        auto sums = PageSums{};
+        auto batch = Instructions{};
+        for (std::string line; std::getline(file, line);) {
+            if (line.find('|') == std::string::npos) {
+                read_printing_instruction(line, rules, batch);
+                continue;
             }
 
-            read_pages.push_back(page_it);
+            process_instructions(batch, rules, sums);
+            if (constexpr auto removal_prefix = '-'; line.front() == removal_prefix) {
+                const auto [first_page, second_page] = parse_rule(std::string_view{line}.substr(1));
+                rules.remove_rule(first_page, second_page);
+            } else {
+                const auto [first_page, second_page] = parse_rule(line);
+                rules.add_rule(first_page, second_page);
+            }
         }
+        process_instructions(batch, rules, sums);
 
-        const auto& middle_page = instruction[instruction.size() / 2];
-        return std::stoi(middle_page);
+        return sums;
     }
 }
 
 auto main() -> int {
     const auto file_path = std::string{"input.txt"};
-    auto [rules, instructions] = read_printing_file(file_path);
-
-    auto middle_page_sum = 0;
-    auto corrected_sum = 0;
-    for (auto& instruction : instructions) {
-        middle_page_sum += process_instruction(instruction, rules, false);
-        corrected_sum += process_instruction(instruction, rules, true);
-    }
-
-    const auto only_corrected_sum = corrected_sum - middle_page_sum;
+    const auto [middle_page_sum, corrected_sum] = process_printing_file(file_path);
 
     std::cout << "Non-corrections:" << middle_page_sum << '\n';
-    std::cout << "Corrections:" << only_corrected_sum << '\n';
+    std::cout << "Corrections:" << corrected_sum << '\n';
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,234 @@
+#include "rule_index.h"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <queue>
+
+[[nodiscard]] auto RuleIndex::rule_row(const PageId page) const noexcept -> std::span<const RuleWord> {
+    return rule_rows[page];
+}
+
+auto RuleIndex::mark_scratch_pages(const std::span<const PageId> pages) noexcept -> void {
+    for (const auto page : pages) {
+        scratch_pages[page / bits_per_word] |= RuleWord{1} << page % bits_per_word;
+    }
+}
+
+// Only the words touched by the pages are reset, so the scratch set costs nothing proportional to the page count
+auto RuleIndex::clear_scratch_pages(const std::span<const PageId> pages) noexcept -> void {
+    for (const auto page : pages) {
+        scratch_pages[page / bits_per_word] = 0;
+    }
+}
+
+[[nodiscard]] auto RuleIndex::intern_page(const int page_number) -> PageId {
+    const auto [it, inserted] = page_ids.try_emplace(page_number, page_numbers.size());
+    if (inserted) {
+        page_numbers.push_back(page_number);
+        rule_rows.emplace_back();
+        scratch_pages.resize((page_numbers.size() + bits_per_word - 1) / bits_per_word);
+    }
+    return it->second;
+}
+
+[[nodiscard]] auto RuleIndex::page_number(const PageId page) const -> int {
+    return page_numbers.at(page);
+}
+
+[[nodiscard]] auto RuleIndex::has_rule(const PageId first_page, const PageId second_page) const noexcept -> bool {
+    const auto row = rule_row(first_page);
+    const auto word_index = second_page / bits_per_word;
+    return word_index < row.size() and (row[word_index] >> second_page % bits_per_word & 1) != 0;
+}
+
+auto RuleIndex::add_rule(const int first_page, const int second_page) -> void {
+    const auto first_id = intern_page(first_page);
+    const auto second_id = intern_page(second_page);
+    auto& row = rule_rows[first_id];
+    if (const auto word_index = second_id / bits_per_word; word_index >= row.size()) {
+        row.resize(word_index + 1);
+    }
+    row[second_id / bits_per_word] |= RuleWord{1} << second_id % bits_per_word;
+}
+
+auto RuleIndex::remove_rule(const int first_page, const int second_page) -> void {
+    const auto first_it = page_ids.find(first_page);
+    const auto second_it = page_ids.find(second_page);
+    if (first_it == page_ids.end() or second_it == page_ids.end()) {
+        return;
+    }
+
+    auto& row = rule_rows[first_it->second];
+    const auto second_id = second_it->second;
+    if (const auto word_index = second_id / bits_per_word; word_index < row.size()) {
+        row[word_index] &= ~(RuleWord{1} << second_id % bits_per_word);
+    }
+}
+
+// Checks every page against the set of pages already printed in one linear scan
+[[nodiscard]] auto RuleIndex::is_valid_update(const std::span<const PageId> update) -> bool {
+    auto is_valid = true;
+    for (auto page_it = update.begin(); page_it != update.end() and is_valid; ++page_it) {
+        const auto row = rule_row(*page_it);
+        for (std::size_t w = 0; w < row.size(); ++w) {
+            if ((row[w] & scratch_pages[w]) != 0) {
+                is_valid = false;
+                break;
+            }
+        }
+        mark_scratch_pages({page_it, 1});
+    }
+
+    clear_scratch_pages(update);
+    return is_valid;
+}
+
+// Orders pages by how many of the update's other pages they must precede, which is exactly the rule order when the
+// rules are a total order over these pages. Anything else falls back to a topological sort.
+auto RuleIndex::correct_update(const std::span<PageId> update) -> void {
+    mark_scratch_pages(update);
+
+    std::vector<std::pair<std::size_t, PageId>> ranked_pages;
+    ranked_pages.reserve(update.size());
+    for (const auto page : update) {
+        const auto row = rule_row(page);
+        std::size_t num_successors = 0;
+        for (std::size_t w = 0; w < row.size(); ++w) {
+            num_successors += std::popcount(row[w] & scratch_pages[w]);
+        }
+        ranked_pages.emplace_back(num_successors, page);
+    }
+    clear_scratch_pages(update);
+
+    std::ranges::stable_sort(ranked_pages, std::greater<>{}, [](const auto& ranked_page) {
+        return ranked_page.first;
+    });
+    std::ranges::transform(ranked_pages, update.begin(), [](const auto& ranked_page) {
+        return ranked_page.second;
+    });
+
+    if (not is_valid_update(update)) {
+        topological_sort(update);
+    }
+}
+
+// Kahn's algorithm over the rules between the update's pages, ties broken by original position. Pages caught in a
+// rule cycle keep their original relative order at the end.
+auto RuleIndex::topological_sort(const std::span<PageId> update) -> void {
+    const auto num_pages = update.size();
+    std::unordered_map<PageId, std::size_t> positions;
+    for (std::size_t i = 0; i < num_pages; ++i) {
+        positions.emplace(update[i], i);
+    }
+    mark_scratch_pages(update);
+
+    std::vector<std::vector<std::size_t>> successors(num_pages);
+    std::vector<std::size_t> num_predecessors(num_pages);
+    for (std::size_t i = 0; i < num_pages; ++i) {
+        const auto row = rule_row(update[i]);
+        for (std::size_t w = 0; w < row.size(); ++w) {
+            for (auto word = row[w] & scratch_pages[w]; word != 0; word &= word - 1) {
+                const auto successor = static_cast<PageId>(w * bits_per_word + std::countr_zero(word));
+                const auto j = positions.at(successor);
+                successors[i].push_back(j);
+                ++num_predecessors[j];
+            }
+        }
+    }
+    clear_scratch_pages(update);
+
+    std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<>> ready;
+    for (std::size_t i = 0; i < num_pages; ++i) {
+        if (num_predecessors[i] == 0) {
+            ready.push(i);
+        }
+    }
+
+    std::vector<PageId> sorted;
+    std::vector<bool> placed(num_pages);
+    sorted.reserve(num_pages);
+    while (not ready.empty()) {
+        const auto i = ready.top();
+        ready.pop();
+        sorted.push_back(update[i]);
+        placed[i] = true;
+
+        for (const auto j : successors[i]) {
+            if (--num_predecessors[j] == 0) {
+                ready.push(j);
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < num_pages; ++i) {
+        if (not placed[i]) {
+            sorted.push_back(update[i]);
+        }
+    }
+    std::ranges::copy(sorted, update.begin());
+}
+
+// Tarjan's strongly connected components over the rules between the given pages. Every component with more than
+// one page, or a single page that must precede itself, is a rule cycle.
+[[nodiscard]] auto RuleIndex::find_rule_cycles(const std::span<const PageId> pages) -> std::vector<std::vector<int>> {
+    std::vector<PageId> distinct_pages(pages.begin(), pages.end());
+    std::ranges::sort(distinct_pages);
+    const auto [first_duplicate, last_duplicate] = std::ranges::unique(distinct_pages);
+    distinct_pages.erase(first_duplicate, last_duplicate);
+
+    constexpr auto unvisited = std::size_t{0};
+    std::unordered_map<PageId, std::size_t> visit_order;
+    std::unordered_map<PageId, std::size_t> low_link;
+    std::vector<PageId> component_stack;
+    std::unordered_map<PageId, bool> on_stack;
+    std::size_t next_order = 1;
+    std::vector<std::vector<int>> cycles;
+
+    mark_scratch_pages(distinct_pages);
+    const std::function<void(PageId)> connect = [&](const PageId page) {
+        visit_order[page] = low_link[page] = next_order++;
+        component_stack.push_back(page);
+        on_stack[page] = true;
+
+        const auto row = rule_row(page);
+        for (std::size_t w = 0; w < row.size(); ++w) {
+            for (auto word = row[w] & scratch_pages[w]; word != 0; word &= word - 1) {
+                const auto successor = static_cast<PageId>(w * bits_per_word + std::countr_zero(word));
+                if (visit_order[successor] == unvisited) {
+                    connect(successor);
+                    low_link[page] = std::min(low_link[page], low_link[successor]);
+                } else if (on_stack[successor]) {
+                    low_link[page] = std::min(low_link[page], visit_order[successor]);
+                }
+            }
+        }
+
+        if (low_link[page] != visit_order[page]) {
+            return;
+        }
+
+        std::vector<int> component;
+        PageId member;
+        do {
+            member = component_stack.back();
+            component_stack.pop_back();
+            on_stack[member] = false;
+            component.push_back(page_numbers[member]);
+        } while (member != page);
+
+        if (component.size() > 1 or has_rule(page, page)) {
+            std::ranges::reverse(component);
+            cycles.push_back(std::move(component));
+        }
+    };
+
+    for (const auto page : distinct_pages) {
+        if (visit_order[page] == unvisited) {
+            connect(page);
+        }
+    }
+    clear_scratch_pages(distinct_pages);
+
+    return cycles;
+}
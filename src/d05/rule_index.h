@@ -0,0 +1,42 @@
+#ifndef RULE_INDEX_H
+#define RULE_INDEX_H
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+using PageId = std::uint32_t;
+
+// Page ordering rules kept as one bit row per page, where bit b of row a is set when page a must be printed before
+// page b. Rows only grow, geometrically, when a rule is written past their end, and bits beyond a row's end read as
+// zero, so new pages never force the other rows to be copied. Rules can be added and removed while update batches are
+// checked against the current set.
+class RuleIndex {
+    using RuleWord = std::uint64_t;
+    static constexpr std::size_t bits_per_word = 64;
+
+    std::unordered_map<int, PageId> page_ids;
+    std::vector<int> page_numbers;
+    std::vector<std::vector<RuleWord>> rule_rows;
+    std::vector<RuleWord> scratch_pages;
+
+    [[nodiscard]] auto rule_row(PageId page) const noexcept -> std::span<const RuleWord>;
+    auto mark_scratch_pages(std::span<const PageId> pages) noexcept -> void;
+    auto clear_scratch_pages(std::span<const PageId> pages) noexcept -> void;
+    auto topological_sort(std::span<PageId> update) -> void;
+
+public:
+    [[nodiscard]] auto intern_page(int page_number) -> PageId;
+    [[nodiscard]] auto page_number(PageId page) const -> int;
+    [[nodiscard]] auto has_rule(PageId first_page, PageId second_page) const noexcept -> bool;
+
+    auto add_rule(int first_page, int second_page) -> void;
+    auto remove_rule(int first_page, int second_page) -> void;
+
+    [[nodiscard]] auto is_valid_update(std::span<const PageId> update) -> bool;
+    auto correct_update(std::span<PageId> update) -> void;
+    [[nodiscard]] auto find_rule_cycles(std::span<const PageId> pages) -> std::vector<std::vector<int>>;
+};
+
+#endif //RULE_INDEX_H
@@ -1,27 +1,31 @@
 #include "guard.h"
 
 auto Guard::turn() noexcept -> void {
-    switch (direction) {
+    auto new_direction = Up;
+    switch (get_direction()) {
         case Up:
-            direction = Right;
+            new_direction = Right;
             break;
         case Down:
-            direction = Left;
+            new_direction = Left;
             break;
         case Left:
-            direction = Up;
+            new_direction = Up;
             break;
         case Right:
-            direction = Down;
+            new_direction = Down;
             break;
     }
+
+    state = pack(new_direction, get_position());
 }
 
 [[nodiscard]] auto Guard::get_front_coordinate() const -> std::pair<int, int> {
+    const auto position = get_position();
     auto signed_x_pos = static_cast<int>(position.x);
     auto signed_y_pos = static_cast<int>(position.y);
 
-    switch (direction) {
+    switch (get_direction()) {
         case Up:
             signed_y_pos -= 1;
             break;
@@ -39,8 +43,18 @@ auto Guard::turn() noexcept -> void {
     return {signed_x_pos, signed_y_pos};
 }
 
+[[nodiscard]] auto Guard::get_position() const noexcept -> Position {
+    const auto coordinates = state >> direction_bits;
+    return {coordinates & coordinate_mask, coordinates >> coordinate_bits & coordinate_mask};
+}
+
+[[nodiscard]] auto Guard::get_direction() const noexcept -> Direction {
+    return static_cast<Direction>(state & direction_mask);
+}
+
 auto Guard::forward() noexcept -> void {
-    switch (direction) {
+    auto position = get_position();
+    switch (get_direction()) {
         case Up:
             position.y -= 1;
             break;
@@ -54,4 +68,10 @@ auto Guard::forward() noexcept -> void {
             position.x += 1;
             break;
     }
-}
\ No newline at end of file
+
+    move_to(position);
+}
+
+auto Guard::move_to(const Position& new_position) noexcept -> void {
+    state = pack(get_direction(), new_position);
+}
@@ -1,6 +1,7 @@
 #ifndef GUARD_H
 #define GUARD_H
 
+#include <cstdint>
 #include <utility>
 
 struct Position {
@@ -18,17 +19,32 @@ enum Direction {
 };
 
 class Guard {
-    Direction direction;
-    Position position;
+    static constexpr auto direction_bits = 2u;
+    static constexpr auto coordinate_bits = 15u;
+    static constexpr auto direction_mask = (1u << direction_bits) - 1;
+    static constexpr auto coordinate_mask = (1u << coordinate_bits) - 1;
+
+    // Packed as [y:15][x:15][direction:2]
+    std::uint32_t state;
+
+    [[nodiscard]] static constexpr auto pack(const Direction direction, const Position& position) noexcept {
+        const auto x = static_cast<std::uint32_t>(position.x);
+        const auto y = static_cast<std::uint32_t>(position.y);
+        return (y << coordinate_bits | x) << direction_bits | static_cast<std::uint32_t>(direction);
+    }
 
 public:
+    static constexpr auto max_coordinate = std::size_t{coordinate_mask};
+
     Guard(const Direction direction, const Position& position)
-        : direction{direction}
-        , position{position} {}
+        : state{pack(direction, position)} {}
 
     [[nodiscard]] auto get_front_coordinate() const -> std::pair<int, int>;
+    [[nodiscard]] auto get_position() const noexcept -> Position;
+    [[nodiscard]] auto get_direction() const noexcept -> Direction;
     auto turn() noexcept -> void;
     auto forward() noexcept -> void;
+    auto move_to(const Position& new_position) noexcept -> void;
 
     bool operator==(const Guard& rhs) const noexcept = default;
 };
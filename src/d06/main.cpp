@@ -1,21 +1,48 @@
-#include <array>
+#include <vector>
 #include <iostream>
 #include <fstream>
 #include <utility>
-#include <ranges>
+#include <cstdint>
+#include <tuple>
+#include <algorithm>
+#include <future>
+#include <thread>
 
 #include "guard.h"
 
 namespace {
-    constexpr auto height = 130;
-    constexpr auto width = 130;
-
     enum PositionState {
         Empty,
         Obstacle,
         Visited,
     };
-    using RoomLayout = std::array<std::array<PositionState, width>, height>;
+    using RoomLayout = std::vector<std::vector<PositionState>>;
+
+    // Distance from a cell to the first obstacle in a direction, or to the room edge when nothing is in the way
+    struct Jump {
+        std::uint32_t distance;
+        bool blocked;
+    };
+
+    struct JumpTable {
+        std::size_t width;
+        std::vector<Jump> jumps;
+    };
+    constexpr auto num_directions = std::size_t{4};
+
+    // A cell on the guard's original route, and the guard as it was just before first stepping onto it
+    struct RouteStep {
+        Position cell;
+        Guard guard;
+    };
+    using Route = std::vector<RouteStep>;
+
+    // Turn states stamped with the generation of the walk that reached them, so starting a new walk only bumps
+    // the generation instead of clearing the table
+    struct VisitedStates {
+        std::vector<std::uint32_t> stamps;
+        std::uint32_t generation = 0;
+    };
 
     auto interpret_position(
         const char position_char,
@@ -64,6 +91,18 @@ namespace {
         auto file = std::ifstream(file_path);
         std::size_t y = 0;
         for (std::string line; std::getline(file, line); ++y) {
+            if (line.empty()) {
+                break;
+            }
+
+            if (y > Guard::max_coordinate or line.size() > Guard::max_coordinate + 1) {
+                throw std::runtime_error("Room too large");
+            }
+            if (not layout.empty() and line.size() != layout.front().size()) {
+                throw std::runtime_error("Room rows must all have the same width");
+            }
+
+            layout.emplace_back(line.size());
             std::size_t x = 0;
             for (const auto c : line) {
                 const Position position = {x, y};
@@ -76,20 +115,79 @@ namespace {
         return {layout, guard};
     }
 
-    [[nodiscard]] auto is_out_of_bounds(const int x, const int y) noexcept -> bool {
-        return x < 0 or y < 0 or x > width or y > height;
+    [[nodiscard]] auto is_out_of_bounds(const RoomLayout& layout, const int x, const int y) noexcept -> bool {
+        return x < 0 or y < 0 or y >= static_cast<int>(layout.size()) or x >= static_cast<int>(layout[y].size());
+    }
+
+    [[nodiscard]] constexpr auto direction_step(const Direction direction) noexcept -> std::pair<int, int> {
+        switch (direction) {
+            case Up:
+                return {0, -1};
+            case Down:
+                return {0, 1};
+            case Left:
+                return {-1, 0};
+            case Right:
+                return {1, 0};
+        }
+        return {0, 0};
+    }
+
+    [[nodiscard]] auto jump_index(const JumpTable& table, const Position& position, const Direction direction) noexcept {
+        return (position.y * table.width + position.x) * num_directions + direction;
     }
 
-    [[nodiscard]] auto count_path_length(RoomLayout layout, Guard guard) -> unsigned int {
-        auto path_length = 0;
+    // Sweeps each row and column once per direction, remembering the last obstacle passed
+    [[nodiscard]] auto build_jump_table(const RoomLayout& layout) -> JumpTable {
+        const auto height = layout.size();
+        const auto width = height == 0 ? std::size_t{0} : layout.front().size();
+        auto table = JumpTable{width, std::vector<Jump>(width * height * num_directions)};
+
+        const auto sweep = [&](const Direction direction, const Position& start, const std::size_t length) {
+            const auto [x_diff, y_diff] = direction_step(direction);
+            auto distance = Jump{1, false};
+            auto position = start;
+            for (std::size_t i = 0; i < length; ++i) {
+                table.jumps[jump_index(table, position, direction)] = distance;
+                if (layout[position.y][position.x] == Obstacle) {
+                    distance = Jump{1, true};
+                } else {
+                    ++distance.distance;
+                }
+
+                position.x -= x_diff;
+                position.y -= y_diff;
+            }
+        };
+
+        for (std::size_t x = 0; x < width; ++x) {
+            sweep(Up, {x, 0}, height);
+            sweep(Down, {x, height - 1}, height);
+        }
+        for (std::size_t y = 0; y < height; ++y) {
+            sweep(Left, {0, y}, width);
+            sweep(Right, {width - 1, y}, width);
+        }
+
+        return table;
+    }
+
+    [[nodiscard]] auto count_path_length(RoomLayout layout, Guard guard, Route& route) -> unsigned int {
+        // The starting cell counts as visited
+        auto path_length = 1U;
 
         auto [next_x_pos, next_y_pos] = guard.get_front_coordinate();
-        while (not is_out_of_bounds(next_x_pos, next_y_pos)) {
+        while (not is_out_of_bounds(layout, next_x_pos, next_y_pos)) {
             if (auto& position_info = layout[next_y_pos][next_x_pos]; position_info == Obstacle) {
                 guard.turn();
             } else {
                 if (position_info != Visited) {
                     ++path_length;
+                    const auto cell = Position{
+                        static_cast<std::size_t>(next_x_pos),
+                        static_cast<std::size_t>(next_y_pos)
+                    };
+                    route.emplace_back(cell, guard);
                 }
 
                 guard.forward();
@@ -102,70 +200,102 @@ namespace {
         return path_length;
     }
 
-    [[nodiscard]] auto is_looping_path(const RoomLayout &layout, Guard guard) -> bool {
-        auto fast_guard = guard;
+    // Moves the guard to the cell where it next turns, returning false if it walks out of the room instead. The
+    // extra obstacle can only cut a jump short when it lies ahead of the guard in its row or column.
+    [[nodiscard]] auto jump_guard(const JumpTable& table, Guard& guard, const Position& extra_obstacle) noexcept -> bool {
+        const auto position = guard.get_position();
+        const auto direction = guard.get_direction();
+        auto [distance, blocked] = table.jumps[jump_index(table, position, direction)];
 
-        const auto try_move_guard = [](const RoomLayout& l, Guard& g) {
-            auto [next_x, next_y] = g.get_front_coordinate();
-            if (is_out_of_bounds(next_x, next_y)) {
-                return false;
-            }
-
-            while (l[next_y][next_x] == Obstacle) {
-                g.turn();
-                std::tie(next_x, next_y) = g.get_front_coordinate();
+        const auto [x_diff, y_diff] = direction_step(direction);
+        const auto x = static_cast<long>(position.x);
+        const auto y = static_cast<long>(position.y);
+        const auto obstacle_x = static_cast<long>(extra_obstacle.x);
+        const auto obstacle_y = static_cast<long>(extra_obstacle.y);
+        auto obstacle_distance = 0L;
+        if (x_diff == 0 and obstacle_x == x) {
+            obstacle_distance = (obstacle_y - y) * y_diff;
+        } else if (y_diff == 0 and obstacle_y == y) {
+            obstacle_distance = (obstacle_x - x) * x_diff;
+        }
 
-                if (is_out_of_bounds(next_x, next_y)) {
-                    return false;
-                }
-            }
+        if (obstacle_distance > 0 and obstacle_distance < distance) {
+            distance = static_cast<std::uint32_t>(obstacle_distance);
+            blocked = true;
+        }
 
-            g.forward();
-            return true;
-        };
+        if (not blocked) {
+            return false;
+        }
 
-        do {
-            if (not try_move_guard(layout, guard)) {
-                return false;
-            }
+        const auto steps = static_cast<long>(distance) - 1;
+        guard.move_to({
+            static_cast<std::size_t>(x + x_diff * steps),
+            static_cast<std::size_t>(y + y_diff * steps)
+        });
+        guard.turn();
+        return true;
+    }
 
-            if (not try_move_guard(layout, fast_guard)) {
-                return false;
-            }
+    // The guard loops as soon as it turns at the same cell in the same direction twice
+    [[nodiscard]] auto is_looping_path(
+        const JumpTable& table,
+        Guard guard,
+        const Position& extra_obstacle,
+        VisitedStates& visited
+    ) -> bool {
+        if (++visited.generation == 0) {
+            std::ranges::fill(visited.stamps, 0);
+            visited.generation = 1;
+        }
 
-            if (not try_move_guard(layout, fast_guard)) {
-                return false;
+        while (jump_guard(table, guard, extra_obstacle)) {
+            auto& stamp = visited.stamps[jump_index(table, guard.get_position(), guard.get_direction())];
+            if (stamp == visited.generation) {
+                return true;
             }
-        } while (fast_guard != guard);
-        return true;
+            stamp = visited.generation;
+        }
+        return false;
     }
 
-    [[nodiscard]] auto count_blocking_obstructions(RoomLayout& layout, const Guard& guard) -> unsigned int {
-        auto num_obstructions = 0;
-        for (auto& y_it : layout) {
-            for (auto& position_info : y_it) {
-                if (position_info != Empty) {
-                    continue;
-                }
-                position_info = Obstacle;
+    // Only cells on the original route can change the guard's path. Up to the first time it reaches such a cell the
+    // walk is unchanged, so each simulation resumes from the recorded guard state instead of the start. Workers share
+    // the read-only jump table and see their candidate only through the extra obstacle passed to each walk.
+    [[nodiscard]] auto count_blocking_obstructions(const JumpTable& table, const Route& route) -> unsigned int {
+        const auto num_workers = std::max(std::thread::hardware_concurrency(), 1u);
 
-                if (is_looping_path(layout, guard)) {
-                    ++num_obstructions;
+        std::vector<std::future<unsigned int>> worker_counts;
+        for (std::size_t worker = 0; worker < num_workers; ++worker) {
+            worker_counts.push_back(std::async(std::launch::async, [&table, &route, worker, num_workers] {
+                auto visited = VisitedStates{std::vector<std::uint32_t>(table.jumps.size())};
+                auto num_obstructions = 0u;
+                for (auto i = worker; i < route.size(); i += num_workers) {
+                    const auto& [cell, guard] = route[i];
+                    if (is_looping_path(table, guard, cell, visited)) {
+                        ++num_obstructions;
+                    }
                 }
-                position_info = Empty;
-            }
+                return num_obstructions;
+            }));
         }
 
+        auto num_obstructions = 0u;
+        for (auto& worker_count : worker_counts) {
+            num_obstructions += worker_count.get();
+        }
         return num_obstructions;
     }
 }
 
 auto main() -> int {
     const auto file_path = "input.txt";
-    auto [layout, guard] = read_layout_from_file(file_path);
+    const auto [layout, guard] = read_layout_from_file(file_path);
+    const auto jump_table = build_jump_table(layout);
 
-    const auto num_visited = count_path_length(layout, guard);
-    const auto num_obstructions = count_blocking_obstructions(layout, guard);
+    Route route;
+    const auto num_visited = count_path_length(layout, guard, route);
+    const auto num_obstructions = count_blocking_obstructions(jump_table, route);
 
     std::cout << "Cells visited: " << num_visited << '\n';
     std::cout << "Blocking obstacle placements: " << num_obstructions << '\n';
@@ -2,19 +2,84 @@
 #include <vector>
 #include <fstream>
 #include <sstream>
-#include <functional>
 #include <algorithm>
+#include <array>
+#include <span>
+#include <optional>
+#include <variant>
+#include <type_traits>
+#include <stdexcept>
 
 namespace {
+    using WideValue = unsigned __int128;
+
+    template <typename Value>
     struct Equation {
-        const unsigned long result;
-        const std::vector<unsigned long> terms;
+        const Value result;
+        const std::vector<Value> terms;
+    };
+
+    // Each equation is stored at the narrowest width that holds all of its numbers
+    struct Equations {
+        std::vector<Equation<unsigned long>> narrow;
+        std::vector<Equation<WideValue>> wide;
     };
-    using Operation = std::function<unsigned long(const unsigned long&, const unsigned long&)>;
-    constexpr auto num_operations = 3;
 
-    [[nodiscard]] auto read_equations_from_file(const std::string& file_path) -> std::vector<Equation> {
-        std::vector<Equation> equations;
+    template <typename Value>
+    struct PowersOfTen {
+        std::array<Value, 40> powers{};
+        std::size_t size = 0;
+    };
+
+    // Every power of ten representable in Value, stopping before the first one that would overflow
+    template <typename Value>
+    constexpr auto powers_of_ten = [] {
+        auto table = PowersOfTen<Value>{};
+        auto power = Value{1};
+        do {
+            table.powers[table.size++] = power;
+        } while (not __builtin_mul_overflow(power, Value{10}, &power));
+        return table;
+    }();
+
+    [[nodiscard]] auto parse_number(const std::string_view number) -> WideValue {
+        auto value = WideValue{0};
+        for (const auto c : number) {
+            if (c < '0' or c > '9') {
+                throw std::invalid_argument("Unexpected character in number");
+            }
+
+            const auto digit = static_cast<WideValue>(c - '0');
+            if (__builtin_mul_overflow(value, WideValue{10}, &value) or __builtin_add_overflow(value, digit, &value)) {
+                throw std::overflow_error("Number does not fit in 128 bits");
+            }
+        }
+        return value;
+    }
+
+    [[nodiscard]] auto to_string(WideValue value) -> std::string {
+        std::string digits;
+        do {
+            digits.push_back(static_cast<char>('0' + static_cast<int>(value % 10)));
+            value /= 10;
+        } while (value != 0);
+
+        std::ranges::reverse(digits);
+        return digits;
+    }
+
+    template <typename Value>
+    [[nodiscard]] auto narrow_equation(const WideValue result, const std::vector<WideValue>& terms) -> Equation<Value> {
+        std::vector<Value> narrow_terms;
+        narrow_terms.reserve(terms.size());
+        for (const auto term : terms) {
+            narrow_terms.push_back(static_cast<Value>(term));
+        }
+        return {static_cast<Value>(result), narrow_terms};
+    }
+
+    [[nodiscard]] auto read_equations_from_file(const std::string& file_path) -> Equations {
+        Equations equations;
 
         auto file = std::ifstream(file_path);
         for (std::string line; std::getline(file, line);) {
@@ -23,70 +88,157 @@ namespace {
             std::string result;
             std::getline(line_stream, result, result_delimiter);
 
-            std::vector<unsigned long> terms;
+            std::vector<WideValue> terms;
             constexpr auto term_delimiter = ' ';
             for (std::string term; std::getline(line_stream, term, term_delimiter);) {
                 if (term.empty()) {
                     continue;
                 }
 
-                const auto numeric_term = std::stoul(term);
+                const auto numeric_term = parse_number(term);
                 terms.push_back(numeric_term);
             }
 
-            const auto numeric_result = std::stoul(result);
-            equations.emplace_back(numeric_result, terms);
+            const auto numeric_result = parse_number(result);
+            constexpr auto narrow_max = WideValue{static_cast<unsigned long>(-1)};
+            const auto fits_narrow = numeric_result <= narrow_max
+                and std::ranges::all_of(terms, [](const WideValue term) { return term <= narrow_max; });
+            if (fits_narrow) {
+                equations.narrow.push_back(narrow_equation<unsigned long>(numeric_result, terms));
+            } else {
+                equations.wide.push_back(narrow_equation<WideValue>(numeric_result, terms));
+            }
         }
 
         return equations;
     }
 
-    [[nodiscard]] auto is_valid_equation(
-        const Equation& equation,
-        const std::array<Operation, num_operations>& operations
-    ) -> bool {
-        const auto& terms = equation.terms;
-        const auto result = equation.result;
+    // Smallest power of ten above the term, i.e. the factor concatenation shifts the left operand by. Zero means the
+    // shift itself would overflow, so no left operand fits.
+    template <typename Value>
+    [[nodiscard]] auto concatenation_shift(const Value term) noexcept -> Value {
+        const auto& [powers, size] = powers_of_ten<Value>;
+        const auto last = powers.begin() + static_cast<std::ptrdiff_t>(size);
+        const auto digits = std::upper_bound(powers.begin() + 1, last, term);
+        return digits == last ? 0 : *digits;
+    }
 
-        if (terms.empty()) {
-            return false;
+    // Each operator undoes itself given the target and the rightmost term, failing when no left operand could
+    // have produced the target without overflowing
+    struct Add {
+        template <typename Value>
+        [[nodiscard]] static auto undo(const Value target, const Value term) noexcept -> std::optional<Value> {
+            if (target < term) {
+                return std::nullopt;
+            }
+            return target - term;
+        }
+    };
+
+    struct Mul {
+        template <typename Value>
+        [[nodiscard]] static auto undo(const Value target, const Value term) noexcept -> std::optional<Value> {
+            if (term == 0 or target % term != 0) {
+                return std::nullopt;
+            }
+            return target / term;
+        }
+    };
+
+    struct Concat {
+        template <typename Value>
+        [[nodiscard]] static auto undo(const Value target, const Value term) noexcept -> std::optional<Value> {
+            const auto shift = concatenation_shift(term);
+            if (shift == 0 or target % shift != term) {
+                return std::nullopt;
+            }
+            return target / shift;
+        }
+    };
+
+    template <typename... Operators>
+    struct OperatorSet {};
+
+    using Part1Operators = OperatorSet<Add, Mul>;
+    using Part2Operators = OperatorSet<Add, Mul, Concat>;
+    using OperatorChoice = std::variant<Part1Operators, Part2Operators>;
+
+    // Peels terms off the right of the equation, only following an operator when it can be undone exactly. Working
+    // backwards only ever shrinks the target, so no intermediate value can overflow.
+    template <typename Value, typename... Operators>
+    [[nodiscard]] auto can_reach(
+        const std::span<const Value> terms,
+        const Value target,
+        const OperatorSet<Operators...> operators
+    ) -> bool {
+        const auto last_term = terms.back();
+        if (terms.size() == 1) {
+            return target == last_term;
         }
 
-        const std::function<bool(std::size_t, const unsigned long&)> evaluate = [&](const std::size_t i, const unsigned long& curr_result) {
-            if (i == terms.size() - 1) {
-                return curr_result == result;
+        // Anything times zero is zero, whatever the remaining terms evaluate to
+        if constexpr ((std::is_same_v<Operators, Mul> or ...)) {
+            if (last_term == 0 and target == 0) {
+                return true;
             }
+        }
 
-            return std::ranges::any_of(operations, [&](const Operation& op) {
-                return evaluate(i + 1, op(curr_result, terms[i + 1]));
-            });
+        const auto remaining_terms = terms.first(terms.size() - 1);
+        const auto try_operator = [&]<typename Operator>() {
+            const auto remaining_target = Operator::undo(target, last_term);
+            return remaining_target and can_reach(remaining_terms, *remaining_target, operators);
         };
+        return (try_operator.template operator()<Operators>() or ...);
+    }
+
+    template <typename Value, typename... Operators>
+    [[nodiscard]] auto is_valid_equation(
+        const Equation<Value>& equation,
+        const OperatorSet<Operators...> operators
+    ) -> bool {
+        if (equation.terms.empty()) {
+            return false;
+        }
+
+        return can_reach(std::span{equation.terms}, equation.result, operators);
+    }
+
+    [[nodiscard]] auto select_operators(const int part) -> OperatorChoice {
+        if (part == 1) {
+            return Part1Operators{};
+        }
+        return Part2Operators{};
+    }
 
-        return evaluate(0, terms[0]);
+    // Dispatches once on the chosen set, so every search below runs with its operators inlined
+    [[nodiscard]] auto sum_valid_equations(
+        const Equations& equations,
+        const OperatorChoice& operator_choice
+    ) -> WideValue {
+        return std::visit([&equations](const auto operators) {
+            WideValue test_value_sum = 0;
+            const auto add_valid_results = [&](const auto& equation_list) {
+                for (const auto& equation : equation_list) {
+                    if (is_valid_equation(equation, operators) and
+                        __builtin_add_overflow(test_value_sum, WideValue{equation.result}, &test_value_sum)) {
+                        throw std::overflow_error("Sum of test values does not fit in 128 bits");
+                    }
+                }
+            };
+
+            add_valid_results(equations.narrow);
+            add_valid_results(equations.wide);
+            return test_value_sum;
+        }, operator_choice);
     }
 }
 
-auto main() -> int {
+auto main(const int argc, const char* argv[]) -> int {
     const auto file_path = std::string{"input.txt"};
     const auto equations = read_equations_from_file(file_path);
 
-    const std::array<Operation, num_operations> operations = {
-        [](const unsigned long& t1, const unsigned long& t2) { return t1 + t2; },
-        [](const unsigned long& t1, const unsigned long& t2) { return t1 * t2; },
-        [](const unsigned long& t1, const unsigned long& t2) {
-            std::stringstream new_num;
-            new_num << t1 << t2;
-
-            return std::stoul(new_num.str());
-        },
-    };
-
-    unsigned long test_value_sum = 0;
-    for (const auto& equation : equations) {
-        if (is_valid_equation(equation, operations)) {
-            test_value_sum += equation.result;
-        }
-    }
-    std::cout << test_value_sum << std::endl;
+    const auto part = argc > 1 ? std::stoi(argv[1]) : 2;
+    const auto test_value_sum = sum_valid_equations(equations, select_operators(part));
+    std::cout << to_string(test_value_sum) << std::endl;
     return 0;
 }
@@ -0,0 +1,71 @@
+#include "antinode_index.h"
+
+#include <algorithm>
+
+AntinodeIndex::AntinodeIndex(const int width, const int height)
+    : width{width}
+    , height{height}
+    , contributing_pairs(static_cast<std::size_t>(width) * height) {}
+
+// Returns false once the cell is off the map, which ends the walk along the pair's line
+auto AntinodeIndex::update_cell(const int x, const int y, const bool adding) noexcept -> bool {
+    if (x < 0 or y < 0 or x >= width or y >= height) {
+        return false;
+    }
+
+    auto& num_pairs = contributing_pairs[static_cast<std::size_t>(y) * width + x];
+    if (adding and num_pairs++ == 0) {
+        ++num_antinodes;
+    } else if (not adding and --num_pairs == 0) {
+        --num_antinodes;
+    }
+    return true;
+}
+
+auto AntinodeIndex::update_pair(const Coordinates& coords1, const Coordinates& coords2, const bool adding) noexcept -> void {
+    if (coords1 == coords2) {
+        return;
+    }
+
+    const auto x_diff = coords2.x - coords1.x;
+    const auto y_diff = coords2.y - coords1.y;
+
+    for (auto num_wavelengths = 0; update_cell(coords1.x - x_diff * num_wavelengths, coords1.y - y_diff * num_wavelengths, adding);) {
+        ++num_wavelengths;
+    }
+    for (auto num_wavelengths = 0; update_cell(coords2.x + x_diff * num_wavelengths, coords2.y + y_diff * num_wavelengths, adding);) {
+        ++num_wavelengths;
+    }
+}
+
+auto AntinodeIndex::add_antenna(const char frequency, const Coordinates& coords) -> void {
+    auto& antennas = frequencies[frequency];
+    for (const auto& other : antennas) {
+        update_pair(other, coords, true);
+    }
+    antennas.push_back(coords);
+}
+
+auto AntinodeIndex::remove_antenna(const char frequency, const Coordinates& coords) -> bool {
+    const auto frequency_it = frequencies.find(frequency);
+    if (frequency_it == frequencies.end()) {
+        return false;
+    }
+
+    auto& antennas = frequency_it->second;
+    const auto antenna_it = std::ranges::find(antennas, coords);
+    if (antenna_it == antennas.end()) {
+        return false;
+    }
+
+    std::iter_swap(antenna_it, std::prev(antennas.end()));
+    antennas.pop_back();
+    for (const auto& other : antennas) {
+        update_pair(other, coords, false);
+    }
+    return true;
+}
+
+auto AntinodeIndex::get_num_antinodes() const noexcept -> std::size_t {
+    return num_antinodes;
+}
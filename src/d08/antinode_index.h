@@ -0,0 +1,36 @@
+#ifndef ANTINODE_INDEX_H
+#define ANTINODE_INDEX_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct Coordinates {
+    int x;
+    int y;
+
+    [[nodiscard]] auto operator==(const Coordinates& other) const -> bool = default;
+};
+
+// Keeps, for every cell, how many antenna pairs place an antinode there, so antennas can be added and removed
+// without recounting the whole map
+class AntinodeIndex {
+    int width;
+    int height;
+    std::unordered_map<char, std::vector<Coordinates>> frequencies;
+    std::vector<std::uint32_t> contributing_pairs;
+    std::size_t num_antinodes = 0;
+
+    auto update_pair(const Coordinates& coords1, const Coordinates& coords2, bool adding) noexcept -> void;
+    auto update_cell(int x, int y, bool adding) noexcept -> bool;
+
+public:
+    AntinodeIndex(int width, int height);
+
+    auto add_antenna(char frequency, const Coordinates& coords) -> void;
+    auto remove_antenna(char frequency, const Coordinates& coords) -> bool;
+
+    [[nodiscard]] auto get_num_antinodes() const noexcept -> std::size_t;
+};
+
+#endif //ANTINODE_INDEX_H
@@ -2,36 +2,50 @@
 #include <unordered_map>
 #include <vector>
 #include <fstream>
-#include <unordered_set>
 #include <ranges>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <sstream>
+
+#include "antinode_index.h"
 
 namespace {
-    struct Coordinates {
-        int x;
-        int y;
+    using Frequencies = std::unordered_map<char, std::vector<Coordinates>>;
+    using BitmapWord = std::uint64_t;
+    constexpr auto bits_per_word = std::size_t{64};
 
-        [[nodiscard]] auto operator==(const Coordinates& other) const -> bool = default;
+    struct AntennaMap {
+        int width = 0;
+        int height = 0;
+        Frequencies frequencies;
     };
 
-    struct CoordinatesHash {
-        [[nodiscard]] auto operator()(const Coordinates& coords) const -> std::size_t {
-            const auto h1 = std::hash<int>()(coords.x);
-            const auto h2 = std::hash<int>()(coords.y);
+    // One bit per cell of the map, set once any antenna pair places an antinode there
+    struct AntinodeBitmap {
+        int width;
+        int height;
+        std::vector<BitmapWord> words;
 
-            // Combine field hash values
-            return h1 ^ h2 << 1;
-        }
+        AntinodeBitmap(const int width, const int height)
+            : width{width}
+            , height{height}
+            , words((static_cast<std::size_t>(width) * height + bits_per_word - 1) / bits_per_word) {}
     };
 
-    using Frequencies = std::unordered_map<char, std::vector<Coordinates>>;
-    using Antinodes = std::unordered_set<Coordinates, CoordinatesHash>;
-
-    [[nodiscard]] auto read_frequencies_from_file(const std::string& file_path) -> Frequencies {
-        Frequencies frequencies;
+    [[nodiscard]] auto read_frequencies_from_file(const std::string& file_path) -> AntennaMap {
+        AntennaMap antenna_map;
+        auto& frequencies = antenna_map.frequencies;
         auto file = std::fstream(file_path);
         auto coords = Coordinates{0, 0};
 
         for (std::string line; std::getline(file, line);) {
+            if (line.empty()) {
+                continue;
+            }
+
             for (const auto& c : line) {
                 if (constexpr auto empty_pos = '.'; c == empty_pos) {
                     ++coords.x;
@@ -45,74 +59,142 @@ namespace {
                 }
                 ++coords.x;
             }
+            antenna_map.width = std::max(antenna_map.width, coords.x);
             coords.x = 0;
             ++coords.y;
         }
+        antenna_map.height = coords.y;
 
-        return frequencies;
+        return antenna_map;
     }
 
-    [[nodiscard]] auto count_antinodes(const Frequencies& frequencies) -> std::size_t {
-        Antinodes antinodes;
+    [[nodiscard]] auto try_mark_antinode(AntinodeBitmap& antinodes, const int x, const int y) noexcept -> bool {
+        if (x < 0 or y < 0 or x >= antinodes.width or y >= antinodes.height) {
+            return false;
+        }
+
+        const auto cell = static_cast<std::size_t>(y) * antinodes.width + x;
+        antinodes.words[cell / bits_per_word] |= BitmapWord{1} << cell % bits_per_word;
+        return true;
+    }
+
+    auto mark_pair_antinodes(AntinodeBitmap& antinodes, const Coordinates& coords1, const Coordinates& coords2) -> void {
+        const auto x_diff = coords2.x - coords1.x;
+        const auto y_diff = coords2.y - coords1.y;
+
+        auto num_wavelengths = 0;
+        bool valid_antinode;
+        do {
+            const auto antinode_x = coords1.x - x_diff * num_wavelengths;
+            const auto antinode_y = coords1.y - y_diff * num_wavelengths;
 
-        const auto try_insert_antinode = [&antinodes](const int x, const int y) {
-            const auto within_bounds = [](const int x_pos, const int y_pos) {
-                constexpr auto max_x = 50;
-                constexpr auto max_y = 50;
-                return x_pos >= 0 and y_pos >= 0 and x_pos < max_x and y_pos < max_y;
-            };
+            valid_antinode = try_mark_antinode(antinodes, antinode_x, antinode_y);
+            ++num_wavelengths;
+        } while (valid_antinode);
 
-            if (const auto coords = Coordinates{x, y}; within_bounds(x, y)) {
-                antinodes.insert(coords);
-                return true;
+        num_wavelengths = 0;
+        do {
+            const auto antinode_x = coords2.x + x_diff * num_wavelengths;
+            const auto antinode_y = coords2.y + y_diff * num_wavelengths;
+
+            valid_antinode = try_mark_antinode(antinodes, antinode_x, antinode_y);
+            ++num_wavelengths;
+        } while (valid_antinode);
+    }
+
+    // Pair loops are split by first antenna and dealt round-robin to workers, each marking its own bitmap. The
+    // bitmaps are OR-ed together and the distinct antinodes counted with a popcount.
+    [[nodiscard]] auto count_antinodes(const AntennaMap& antenna_map) -> std::size_t {
+        std::vector<std::pair<const std::vector<Coordinates>*, std::size_t>> first_antennas;
+        for (const auto& coordinates : antenna_map.frequencies | std::views::values) {
+            for (std::size_t i = 0; i < coordinates.size(); ++i) {
+                first_antennas.emplace_back(&coordinates, i);
             }
+        }
 
-            return false;
-        };
-
-        for (const auto& coordinates : frequencies | std::views::values) {
-            for (auto it1 = coordinates.cbegin(); it1 != coordinates.cend(); ++it1) {
-                for (auto it2 = std::next(it1); it2 != coordinates.cend(); ++it2) {
-                    const auto coords1 = *it1;
-                    const auto coords2 = *it2;
-                    if (coords1 == coords2) {
-                        continue;
+        const auto num_workers = std::max(std::thread::hardware_concurrency(), 1u);
+        std::vector<std::future<AntinodeBitmap>> worker_bitmaps;
+        for (std::size_t worker = 0; worker < num_workers; ++worker) {
+            worker_bitmaps.push_back(std::async(std::launch::async, [&antenna_map, &first_antennas, worker, num_workers] {
+                auto antinodes = AntinodeBitmap(antenna_map.width, antenna_map.height);
+                for (auto task = worker; task < first_antennas.size(); task += num_workers) {
+                    const auto& [coordinates, i] = first_antennas[task];
+                    for (auto j = i + 1; j < coordinates->size(); ++j) {
+                        const auto coords1 = (*coordinates)[i];
+                        const auto coords2 = (*coordinates)[j];
+                        if (coords1 == coords2) {
+                            continue;
+                        }
+
+                        mark_pair_antinodes(antinodes, coords1, coords2);
                     }
+                }
+                return antinodes;
+            }));
+        }
 
-                    const auto x_diff = coords2.x - coords1.x;
-                    const auto y_diff = coords2.y - coords1.y;
+        auto antinodes = worker_bitmaps.front().get();
+        for (auto it = std::next(worker_bitmaps.begin()); it != worker_bitmaps.end(); ++it) {
+            const auto worker_antinodes = it->get();
+            for (std::size_t w = 0; w < antinodes.words.size(); ++w) {
+                antinodes.words[w] |= worker_antinodes.words[w];
+            }
+        }
 
-                    auto num_wavelengths = 0;
-                    bool valid_antinode;
-                    do {
-                        const auto antinode_x = coords1.x - x_diff * num_wavelengths;
-                        const auto antinode_y = coords1.y - y_diff * num_wavelengths;
+        std::size_t num_antinodes = 0;
+        for (const auto word : antinodes.words) {
+            num_antinodes += std::popcount(word);
+        }
+        return num_antinodes;
+    }
 
-                        valid_antinode = try_insert_antinode(antinode_x, antinode_y);
-                        ++num_wavelengths;
-                    } while (valid_antinode);
+    [[nodiscard]] auto build_antinode_index(const AntennaMap& antenna_map) -> AntinodeIndex {
+        auto index = AntinodeIndex(antenna_map.width, antenna_map.height);
+        for (const auto& [frequency, coordinates] : antenna_map.frequencies) {
+            for (const auto& coords : coordinates) {
+                index.add_antenna(frequency, coords);
+            }
+        }
+        return index;
+    }
 
-                    num_wavelengths = 0;
-                    do {
-                        const auto antinode_x = coords2.x + x_diff * num_wavelengths;
-                        const auto antinode_y = coords2.y + y_diff * num_wavelengths;
+    // Each edit line is '+' or '-', then a frequency and the antenna's x and y, e.g. "+a 4 7". A move is a removal
+    // followed by an addition. The antinode count is reported after every edit.
+    auto apply_antenna_edits(const std::string& file_path, AntinodeIndex& index) -> void {
+        auto file = std::fstream(file_path);
+        for (std::string line; std::getline(file, line);) {
+            auto line_stream = std::stringstream(line);
+            char operation;
+            char frequency;
+            auto coords = Coordinates{0, 0};
+            if (not (line_stream >> operation >> frequency >> coords.x >> coords.y)) {
+                continue;
+            }
 
-                        valid_antinode = try_insert_antinode(antinode_x, antinode_y);
-                        ++num_wavelengths;
-                    } while (valid_antinode);
+            if (constexpr auto removal = '-'; operation == removal) {
+                if (not index.remove_antenna(frequency, coords)) {
+                    std::cout << "No '" << frequency << "' antenna at " << coords.x << ',' << coords.y << '\n';
+                    continue;
                 }
+            } else {
+                index.add_antenna(frequency, coords);
             }
-        }
 
-        return antinodes.size();
+            std::cout << line << ": " << index.get_num_antinodes() << '\n';
+        }
     }
 }
 
 auto main() -> int {
     const auto file_path = std::string{"input.txt"};
-    const auto frequencies = read_frequencies_from_file(file_path);
-    const auto num_antinodes = count_antinodes(frequencies);
+    const auto antenna_map = read_frequencies_from_file(file_path);
+    const auto num_antinodes = count_antinodes(antenna_map);
 
     std::cout << num_antinodes << '\n';
+
+    if (const auto edits_path = std::string{"edits.txt"}; std::ifstream(edits_path).good()) {
+        auto index = build_antinode_index(antenna_map);
+        apply_antenna_edits(edits_path, index);
+    }
     return 0;
-}
\ No newline at end of file
+}
@@ -1,121 +1,391 @@
 #include <algorithm>
 #include <iostream>
 #include <vector>
-#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <array>
+#include <queue>
+#include <deque>
+#include <cstdint>
+#include <functional>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace {
-    struct Block {
-        bool is_empty;
-        uint id;
+    // Checksums outgrow 64 bits once the map is a few million digits long
+    using Checksum = unsigned __int128;
+
+    struct Span {
+        std::size_t start;
         std::size_t length;
     };
 
-    [[nodiscard]] auto read_disk_from_file(const std::string& file_path) -> std::vector<Block> {
-        auto file = std::ifstream(file_path);
-        std::string disk;
-        std::getline(file, disk);
+    struct Extent {
+        uint id;
+        Span span;
+    };
+
+    // The disk as runs rather than blocks, so its size scales with the number of digits in the map
+    struct Disk {
+        std::vector<Extent> files;
+        std::vector<Span> free_spans;
+    };
+
+    // Read-only mapping of the input, so the streaming checksums never copy the map into memory
+    struct MappedFile {
+        const char* data = nullptr;
+        std::size_t size = 0;
+
+        explicit MappedFile(const std::string& file_path) {
+            const auto fd = open(file_path.c_str(), O_RDONLY);
+            if (fd == -1) {
+                throw std::runtime_error("Could not open " + file_path);
+            }
 
-        std::vector<Block> blocks;
+            struct stat file_info{};
+            fstat(fd, &file_info);
+            size = static_cast<std::size_t>(file_info.st_size);
+            if (size != 0) {
+                void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED) {
+                    close(fd);
+                    throw std::runtime_error("Could not map " + file_path);
+                }
+                data = static_cast<const char*>(mapping);
+            }
+            close(fd);
+        }
+
+        ~MappedFile() {
+            if (data != nullptr) {
+                munmap(const_cast<char*>(data), size);
+            }
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        auto operator=(const MappedFile&) -> MappedFile& = delete;
+    };
+
+    // Maps at least this many digits long are checksummed straight from the mapping instead of as extents
+    constexpr auto streaming_threshold = std::size_t{1} << 22;
+
+    [[nodiscard]] auto disk_map_digits(const MappedFile& mapped_file) -> std::span<const char> {
+        auto length = mapped_file.size;
+        while (length != 0 and (mapped_file.data[length - 1] < '0' or mapped_file.data[length - 1] > '9')) {
+            --length;
+        }
+        return {mapped_file.data, length};
+    }
+
+    [[nodiscard]] auto read_disk(const std::span<const char> disk_map) -> Disk {
+        Disk disk;
         auto is_free_space = false;
         uint curr_id = 0;
-        for (const auto& c : disk) {
+        std::size_t position = 0;
+        for (const auto& c : disk_map) {
             const std::size_t block_length = c - '0';
-            for (std::size_t i = 0; i < block_length; ++i) {
-                const auto id = is_free_space ? 0 : curr_id;
-                const auto new_block = Block{is_free_space, id, block_length};
-                blocks.push_back(new_block);
+            if (is_free_space) {
+                disk.free_spans.push_back(Span{position, block_length});
+            } else {
+                disk.files.push_back(Extent{curr_id++, Span{position, block_length}});
             }
 
-            if (not is_free_space) {
-                ++curr_id;
-            }
+            position += block_length;
             is_free_space = not is_free_space;
         }
 
-        return blocks;
+        return disk;
     }
 
-    [[nodiscard]] auto block_compact_disk(std::vector<Block> disk) -> std::vector<Block> {
-        const auto is_free_space = [](const Block& block){ return block.is_empty; };
-        for (auto block_it = disk.rbegin(); block_it != disk.rend(); ++block_it) {
-            if (block_it->is_empty) {
-                continue;
+    [[nodiscard]] constexpr auto extent_checksum(const uint id, const std::size_t start, const std::size_t length) noexcept
+        -> Checksum {
+        return Checksum{id} * (length * start + length * (length - 1) / 2);
+    }
+
+    // Walks free spans from the front and file blocks from the back, filling each gap with the tail of the
+    // rightmost file until the two cursors meet
+    [[nodiscard]] auto block_compact_disk(const Disk& disk) -> std::vector<Extent> {
+        const auto& files = disk.files;
+        std::vector<Extent> compacted;
+
+        auto back_file = files.size();
+        std::size_t remaining_length = 0;
+        const auto next_back_file = [&] {
+            while (remaining_length == 0 and back_file > 0) {
+                --back_file;
+                remaining_length = files[back_file].span.length;
             }
-            const auto forward_block_it = std::next(block_it).base();
-            const auto empty_it = std::find_if(disk.begin(), forward_block_it, is_free_space);
+            return remaining_length != 0;
+        };
+
+        for (auto [start, length] : disk.free_spans) {
+            while (length != 0 and next_back_file() and start < files[back_file].span.start) {
+                const auto moved_length = std::min(length, remaining_length);
+                compacted.push_back(Extent{files[back_file].id, Span{start, moved_length}});
 
-            std::swap(*block_it, *empty_it);
+                start += moved_length;
+                length -= moved_length;
+                remaining_length -= moved_length;
+            }
+
+            if (remaining_length != 0 and start >= files[back_file].span.start) {
+                break;
+            }
         }
 
-        return disk;
+        // Everything left of the back cursor stays where it was
+        if (remaining_length != 0) {
+            compacted.push_back(Extent{files[back_file].id, Span{files[back_file].span.start, remaining_length}});
+        }
+        compacted.insert(compacted.end(), files.begin(), files.begin() + static_cast<std::ptrdiff_t>(back_file));
+
+        return compacted;
     }
 
-    [[nodiscard]] auto file_compact_disk(std::vector<Block> disk) -> std::vector<Block> {
-        for (auto file_it = disk.rbegin(); file_it != disk.rend();) {
-            const auto file_length = file_it->length;
-            if (file_length == 0) {
-                ++file_it;
-                continue;
+    // Min-heaps of free span starts, one per span length, so the leftmost span of at least a given length is the
+    // smallest top among the heaps for that length and above
+    constexpr auto max_span_length = std::size_t{9};
+    using SpanStarts = std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<>>;
+    using FreeSpanIndex = std::array<SpanStarts, max_span_length + 1>;
+
+    [[nodiscard]] auto build_free_span_index(const std::vector<Span>& free_spans) -> FreeSpanIndex {
+        FreeSpanIndex index;
+        for (const auto& [start, length] : free_spans) {
+            if (length != 0) {
+                index[length].push(start);
             }
-            if (file_it->is_empty) {
-                std::advance(file_it, file_length);
+        }
+        return index;
+    }
+
+    [[nodiscard]] auto file_compact_disk(const Disk& disk) -> std::vector<Extent> {
+        auto files = disk.files;
+        auto free_span_index = build_free_span_index(disk.free_spans);
+
+        for (auto file_it = files.rbegin(); file_it != files.rend(); ++file_it) {
+            auto& [start, length] = file_it->span;
+            if (length == 0 or length > max_span_length) {
                 continue;
             }
 
-            // Check for empty space of required length
-            const auto forward_file_it = std::next(file_it).base();
-            const auto is_valid_space = [file_length](const Block& block) {
-                return block.is_empty and block.length >= file_length;
-            };
-            auto empty_it = std::find_if(disk.begin(), forward_file_it, is_valid_space);
-            if (empty_it == forward_file_it) {
-                std::advance(file_it, file_length);
+            // Find the leftmost span before the file with room for it
+            auto best_length = std::size_t{0};
+            for (auto span_length = length; span_length <= max_span_length; ++span_length) {
+                const auto& starts = free_span_index[span_length];
+                if (starts.empty() or starts.top() >= start) {
+                    continue;
+                }
+                if (best_length == 0 or starts.top() < free_span_index[best_length].top()) {
+                    best_length = span_length;
+                }
+            }
+            if (best_length == 0) {
                 continue;
             }
 
-            // Switch blocks in file
-            const auto free_space = empty_it->length - file_length;
-            auto block_to_move_it = file_it;
-            for (auto i = 0; i < file_length; ++i, ++block_to_move_it, ++empty_it) {
-                std::swap(*block_to_move_it, *empty_it);
+            auto& best_starts = free_span_index[best_length];
+            const auto span_start = best_starts.top();
+            best_starts.pop();
+            if (const auto leftover_length = best_length - length; leftover_length != 0) {
+                free_span_index[leftover_length].push(span_start + length);
             }
 
-            for (auto i = 0; i < free_space; ++i, ++empty_it) {
-                empty_it->length = free_space;
+            start = span_start;
+        }
+
+        return files;
+    }
+
+    // Each extent contributes id * (start + ... + start + length - 1), summed with the arithmetic series formula
+    [[nodiscard]] auto calculate_checksum(const std::vector<Extent>& extents) -> Checksum {
+        Checksum checksum = 0;
+        for (const auto& [id, span] : extents) {
+            checksum += extent_checksum(id, span.start, span.length);
+        }
+
+        return checksum;
+    }
+
+    [[nodiscard]] constexpr auto original_length(const char digit) noexcept -> std::size_t {
+        return static_cast<std::size_t>(digit - '0');
+    }
+
+    // Block compaction checksum read from both ends of the map at once, with a front cursor over free space and a
+    // back cursor over the files still to be moved
+    [[nodiscard]] auto stream_block_checksum(const std::span<const char> disk_map) -> Checksum {
+        if (disk_map.empty()) {
+            return 0;
+        }
+
+        auto back = (disk_map.size() - 1) & ~std::size_t{1};
+        auto back_remaining = original_length(disk_map[back]);
+        Checksum checksum = 0;
+        std::size_t position = 0;
+
+        for (std::size_t i = 0; i <= back; ++i) {
+            const auto length = original_length(disk_map[i]);
+            if (i % 2 == 0) {
+                const auto file_length = i == back ? back_remaining : length;
+                checksum += extent_checksum(static_cast<uint>(i / 2), position, file_length);
+                position += file_length;
+                continue;
             }
 
-            std::advance(file_it, file_length);
+            auto free_length = length;
+            while (free_length != 0 and back > i) {
+                if (back_remaining == 0) {
+                    back -= 2;
+                    back_remaining = back > i ? original_length(disk_map[back]) : 0;
+                    continue;
+                }
+
+                const auto moved_length = std::min(free_length, back_remaining);
+                checksum += extent_checksum(static_cast<uint>(back / 2), position, moved_length);
+                position += moved_length;
+                free_length -= moved_length;
+                back_remaining -= moved_length;
+            }
         }
 
-        return disk;
+        return checksum;
     }
 
-    [[nodiscard]] auto calculate_checksum(const std::vector<Block>& disk) -> unsigned long {
-        unsigned long checksum = 0;
-        for (std::size_t i = 0; i < disk.size(); ++i) {
-            const auto [is_empty, id, _] = disk[i];
-            if (is_empty) {
+    // Remaining capacity of the free spans the cursors can still reach, from the first span that is not yet full up
+    // to the furthest one a file has moved into. Spans past that window are untouched and keep their original length.
+    class SpanCapacities {
+        static constexpr auto untouched = std::uint8_t{0xFF};
+
+        std::span<const char> disk_map;
+        std::deque<std::uint8_t> remaining;
+        std::size_t first_span = 1;
+
+    public:
+        explicit SpanCapacities(const std::span<const char> disk_map) : disk_map{disk_map} {}
+
+        [[nodiscard]] auto get(const std::size_t span_index) const -> std::size_t {
+            const auto slot = (span_index - first_span) / 2;
+            if (slot < remaining.size() and remaining[slot] != untouched) {
+                return remaining[slot];
+            }
+            return original_length(disk_map[span_index]);
+        }
+
+        auto set(const std::size_t span_index, const std::size_t length) -> void {
+            const auto slot = (span_index - first_span) / 2;
+            if (slot >= remaining.size()) {
+                remaining.resize(slot + 1, untouched);
+            }
+            remaining[slot] = static_cast<std::uint8_t>(length);
+        }
+
+        // Spans before the first one with any room left are never looked at again
+        auto drop_before(const std::size_t span_index) -> void {
+            while (first_span < span_index) {
+                if (not remaining.empty()) {
+                    remaining.pop_front();
+                }
+                first_span += 2;
+            }
+        }
+
+        [[nodiscard]] auto window_size() const noexcept -> std::size_t {
+            return remaining.size();
+        }
+    };
+
+    // Whole-file compaction checksum with one forward cursor per file length, each resting on the leftmost span with
+    // room for that length. Span capacity only ever shrinks, so every cursor crosses the map at most once. Working
+    // memory is the window of partly filled spans between the length-1 cursor and the furthest span written to; it
+    // is independent of the map size on typical inputs, but an input that strands a partly filled span near the start
+    // while files keep landing far to its right can still grow it towards one byte per free span.
+    [[nodiscard]] auto stream_file_checksum(const std::span<const char> disk_map) -> Checksum {
+        struct SpanCursor {
+            std::size_t index;
+            std::size_t position;
+        };
+
+        std::size_t total_length = 0;
+        for (const auto digit : disk_map) {
+            total_length += original_length(digit);
+        }
+
+        auto capacities = SpanCapacities(disk_map);
+        const auto first_span_position = disk_map.empty() ? 0 : original_length(disk_map[0]);
+        std::array<SpanCursor, max_span_length + 1> cursors;
+        cursors.fill(SpanCursor{1, first_span_position});
+
+        // Spans at or past the current file are of no use to it or to any file left of it
+        const auto settle_cursors = [&](const std::size_t limit) {
+            for (std::size_t length = 1; length <= max_span_length; ++length) {
+                auto& [span_index, span_position] = cursors[length];
+                while (span_index < limit and capacities.get(span_index) < length) {
+                    span_position += original_length(disk_map[span_index]) + original_length(disk_map[span_index + 1]);
+                    span_index += 2;
+                }
+            }
+            capacities.drop_before(cursors[1].index);
+        };
+
+        Checksum checksum = 0;
+        auto position = total_length;
+        for (auto i = disk_map.size(); i-- > 0;) {
+            const auto length = original_length(disk_map[i]);
+            position -= length;
+            if (i % 2 != 0 or length == 0) {
+                continue;
+            }
+
+            const auto id = static_cast<uint>(i / 2);
+            settle_cursors(i);
+            const auto [span_index, span_position] = cursors[std::min(length, max_span_length)];
+            if (span_index >= i) {
+                checksum += extent_checksum(id, position, length);
                 continue;
             }
 
-            checksum += id * i;
+            const auto span_length = original_length(disk_map[span_index]);
+            const auto span_remaining = capacities.get(span_index);
+            checksum += extent_checksum(id, span_position + span_length - span_remaining, length);
+            capacities.set(span_index, span_remaining - length);
         }
 
         return checksum;
     }
+
+    [[nodiscard]] auto to_string(Checksum value) -> std::string {
+        std::string digits;
+        do {
+            digits.push_back(static_cast<char>('0' + static_cast<int>(value % 10)));
+            value /= 10;
+        } while (value != 0);
+
+        std::ranges::reverse(digits);
+        return digits;
+    }
 }
 
 auto main() -> int {
     const auto file_path = std::string{"input.txt"};
-    const auto disk = read_disk_from_file(file_path);
+    const auto mapped_file = MappedFile(file_path);
+    const auto disk_map = disk_map_digits(mapped_file);
 
-    const auto block_compacted_disk = block_compact_disk(disk);
-    const auto block_move_checksum = calculate_checksum(block_compacted_disk);
-    std::cout << "Checksum by moving blocks: " << block_move_checksum << '\n';
+    Checksum block_move_checksum;
+    Checksum file_move_checksum;
+    if (disk_map.size() >= streaming_threshold) {
+        block_move_checksum = stream_block_checksum(disk_map);
+        file_move_checksum = stream_file_checksum(disk_map);
+    } else {
+        const auto disk = read_disk(disk_map);
+        block_move_checksum = calculate_checksum(block_compact_disk(disk));
+        file_move_checksum = calculate_checksum(file_compact_disk(disk));
+    }
 
-    const auto file_compacted_disk = file_compact_disk(disk);
-    const auto file_move_checksum = calculate_checksum(file_compacted_disk);
-    std::cout << "Checksum by moving files:  " << file_move_checksum << '\n';
+    std::cout << "Checksum by moving blocks: " << to_string(block_move_checksum) << '\n';
+    std::cout << "Checksum by moving files:  " << to_string(file_move_checksum) << '\n';
 
     return 0;
-}
\ No newline at end of file
+}
@@ -3,123 +3,194 @@
 #include <cstdint>
 #include <fstream>
 #include <array>
-#include <functional>
-#include <queue>
-#include <unordered_set>
+#include <bit>
+#include <algorithm>
 
 namespace {
-    constexpr auto map_height = 60;
-    constexpr auto map_width = 60;
-    using TopographicMap = std::array<std::array<uint8_t, map_width>, map_height>;
+    constexpr auto max_height = uint8_t{9};
+    constexpr auto impassable = uint8_t{0xFF};
 
-    struct Coordinates {
-        std::size_t x;
-        std::size_t y;
+    struct TopographicMap {
+        std::size_t width = 0;
+        std::size_t height = 0;
+        std::vector<uint8_t> heights;
+    };
 
-        [[nodiscard]] auto operator==(const Coordinates& other) const -> bool = default;
+    // Cells a traversal has touched are stamped with its generation, so the visited array never needs clearing
+    struct TraversalScratch {
+        std::vector<std::uint32_t> frontier;
+        std::vector<std::uint32_t> visited;
+        std::uint32_t generation = 0;
     };
 
-    struct CoordinatesHasher {
-        [[nodiscard]] auto operator()(const Coordinates& coords) const -> std::size_t {
-            return coords.x ^ coords.y << 1;
-        }
+    // Number of distinct trails reaching a cell
+    struct RatingMetric {
+        using Value = unsigned long;
+
+        static auto combine(Value& into, const Value from) -> void { into += from; }
+        [[nodiscard]] static auto tally(const Value value) -> unsigned long { return value; }
     };
 
-    using CoordinatesSet = std::unordered_set<Coordinates, CoordinatesHasher>;
+    // Set of peaks, out of the current pass of 64, reachable from a cell
+    struct ScoreMetric {
+        using Value = std::uint64_t;
+
+        static auto combine(Value& into, const Value from) -> void { into |= from; }
+        [[nodiscard]] static auto tally(const Value value) -> unsigned long { return std::popcount(value); }
+    };
 
-    [[nodiscard]] auto read_map_from_file(
-        const std::string& file_path
-    ) -> std::pair<TopographicMap, std::vector<Coordinates>> {
+    [[nodiscard]] auto read_map_from_file(const std::string& file_path) -> TopographicMap {
         auto file = std::ifstream(file_path);
         TopographicMap topographic_map;
-        std::vector<Coordinates> trailhead_coords;
 
-        std::size_t row = 0;
-        for (std::string line; std::getline(file, line); ++row) {
-            std::size_t col = 0;
+        for (std::string line; std::getline(file, line);) {
+            if (line.empty()) {
+                continue;
+            }
+
+            topographic_map.width = line.size();
+            ++topographic_map.height;
             for (const auto& c : line) {
-                const uint8_t height = c - '0';
-                if (height == 0) {
-                    trailhead_coords.emplace_back(Coordinates{col, row});
-                }
+                const auto is_height = c >= '0' and c <= '9';
+                topographic_map.heights.push_back(is_height ? static_cast<uint8_t>(c - '0') : impassable);
+            }
+        }
+        return topographic_map;
+    }
 
-                topographic_map[row][col] = height;
-                ++col;
+    [[nodiscard]] auto find_peaks(const TopographicMap& topographic_map) -> std::vector<std::uint32_t> {
+        std::vector<std::uint32_t> peaks;
+        for (std::uint32_t cell = 0; cell < topographic_map.heights.size(); ++cell) {
+            if (topographic_map.heights[cell] == max_height) {
+                peaks.push_back(cell);
             }
         }
-        return {topographic_map, trailhead_coords};
+        return peaks;
     }
 
-    [[nodiscard]] auto calculate_trailhead_metric(
-        const TopographicMap& topographic_map,
-        const Coordinates& coordinates,
-        const std::function<bool(uint&, uint, const Coordinates&, CoordinatesSet&)>& metric_requirements
-    ) -> uint {
-        constexpr std::pair<int, int> directions[4] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
-        auto coordinates_queue = std::queue<Coordinates>{{coordinates}};
+    // The frontier only ever holds two adjacent heights, so the ring is sized for the largest such pair
+    [[nodiscard]] auto make_traversal_scratch(const TopographicMap& topographic_map) -> TraversalScratch {
+        std::array<std::size_t, max_height + 1> cells_per_height{};
+        for (const auto height : topographic_map.heights) {
+            if (height <= max_height) {
+                ++cells_per_height[height];
+            }
+        }
+
+        auto widest_pair = std::size_t{1};
+        for (std::size_t height = 1; height <= max_height; ++height) {
+            widest_pair = std::max(widest_pair, cells_per_height[height - 1] + cells_per_height[height]);
+        }
+
+        TraversalScratch scratch;
+        scratch.frontier.resize(std::bit_ceil(widest_pair));
+        scratch.visited.resize(topographic_map.heights.size());
+        return scratch;
+    }
 
-        const auto within_bounds = [](const int x, const int y) {
-            return x >= 0 and y >= 0 and x < map_width and y < map_height;
+    // Calls visit for every neighbour exactly one step lower than the cell
+    template <typename Visit>
+    auto for_each_downhill_neighbour(const TopographicMap& topographic_map, const std::uint32_t cell, Visit&& visit) -> void {
+        const auto width = topographic_map.width;
+        const auto x = cell % width;
+        const auto next_height = topographic_map.heights[cell] - 1;
+        const auto try_visit = [&](const std::uint32_t neighbour) {
+            if (topographic_map.heights[neighbour] == next_height) {
+                visit(neighbour);
+            }
         };
 
-        uint trailhead_score = 0;
-        CoordinatesSet peaks_reached;
-        while (not coordinates_queue.empty()) {
-            const auto curr_coords = coordinates_queue.front();
-            const auto [curr_x, curr_y] = curr_coords;
-            coordinates_queue.pop();
+        if (x > 0) {
+            try_visit(cell - 1);
+        }
+        if (x + 1 < width) {
+            try_visit(cell + 1);
+        }
+        if (cell >= width) {
+            try_visit(cell - width);
+        }
+        if (cell + width < topographic_map.heights.size()) {
+            try_visit(cell + width);
+        }
+    }
+
+    // Walks down from the seeded peaks one height at a time, folding each cell's metric into its downhill neighbours.
+    // The FIFO frontier drains a whole height before the next, so a cell's value is final by the time it is dequeued.
+    template <typename Metric>
+    [[nodiscard]] auto propagate_metric(const TopographicMap& topographic_map, const std::vector<std::uint32_t>& seeds,
+                                        const std::vector<typename Metric::Value>& seed_values,
+                                        std::vector<typename Metric::Value>& values,
+                                        TraversalScratch& scratch) -> unsigned long {
+        const auto mask = scratch.frontier.size() - 1;
+        const auto generation = ++scratch.generation;
+        std::size_t head = 0;
+        std::size_t tail = 0;
+
+        for (std::size_t i = 0; i < seeds.size(); ++i) {
+            scratch.visited[seeds[i]] = generation;
+            values[seeds[i]] = seed_values[i];
+            scratch.frontier[tail++ & mask] = seeds[i];
+        }
 
-            const auto curr_height = topographic_map[curr_y][curr_x];
-            if (metric_requirements(trailhead_score, curr_height, curr_coords, peaks_reached)) {
+        unsigned long total = 0;
+        while (head != tail) {
+            const auto cell = scratch.frontier[head++ & mask];
+            if (topographic_map.heights[cell] == 0) {
+                total += Metric::tally(values[cell]);
                 continue;
             }
 
-            for (const auto& [x_diff, y_diff] : directions) {
-                const auto x = static_cast<int>(curr_x) + x_diff;
-                const auto y = static_cast<int>(curr_y) + y_diff;
-
-                if (not within_bounds(x, y) or curr_height + 1 != topographic_map[y][x]) {
-                    continue;
+            for_each_downhill_neighbour(topographic_map, cell, [&](const std::uint32_t neighbour) {
+                if (scratch.visited[neighbour] != generation) {
+                    scratch.visited[neighbour] = generation;
+                    values[neighbour] = typename Metric::Value{};
+                    scratch.frontier[tail++ & mask] = neighbour;
                 }
+                Metric::combine(values[neighbour], values[cell]);
+            });
+        }
+        return total;
+    }
 
-                coordinates_queue.push(Coordinates{
-                    static_cast<std::size_t>(x),
-                    static_cast<std::size_t>(y)
-                });
+    [[nodiscard]] auto calculate_rating_sum(const TopographicMap& topographic_map, const std::vector<std::uint32_t>& peaks,
+                                            TraversalScratch& scratch) -> unsigned long {
+        std::vector<RatingMetric::Value> trails(topographic_map.heights.size());
+        const auto seed_values = std::vector<RatingMetric::Value>(peaks.size(), 1);
+        return propagate_metric<RatingMetric>(topographic_map, peaks, seed_values, trails, scratch);
+    }
+
+    // Peaks are handled 64 at a time, so memory stays at one word per cell however many peaks the map has
+    [[nodiscard]] auto calculate_score_sum(const TopographicMap& topographic_map, const std::vector<std::uint32_t>& peaks,
+                                           TraversalScratch& scratch) -> unsigned long {
+        constexpr auto peaks_per_pass = std::size_t{64};
+
+        std::vector<ScoreMetric::Value> reachable_peaks(topographic_map.heights.size());
+        std::vector<std::uint32_t> pass_peaks;
+        std::vector<ScoreMetric::Value> pass_bits;
+        unsigned long score_sum = 0;
+
+        for (std::size_t first_peak = 0; first_peak < peaks.size(); first_peak += peaks_per_pass) {
+            const auto last_peak = std::min(first_peak + peaks_per_pass, peaks.size());
+            pass_peaks.assign(peaks.begin() + first_peak, peaks.begin() + last_peak);
+            pass_bits.clear();
+            for (auto i = first_peak; i < last_peak; ++i) {
+                pass_bits.push_back(ScoreMetric::Value{1} << (i - first_peak));
             }
+            score_sum += propagate_metric<ScoreMetric>(topographic_map, pass_peaks, pass_bits, reachable_peaks, scratch);
         }
 
-        return trailhead_score;
+        return score_sum;
     }
 }
 
 auto main() -> int {
     const auto file_path = std::string{"input.txt"};
-    const auto [topographic_map, trailhead_coords] = read_map_from_file(file_path);
-
-    constexpr auto max_height = 9;
-    const auto score_calculation = [](uint& curr_score, const uint height, const Coordinates& coords, CoordinatesSet& peaks_reached) {
-        if (height == max_height and not peaks_reached.contains(coords)) {
-            curr_score += 1;
-            peaks_reached.insert(coords);
-            return true;
-        }
-        return false;
-    };
-    const auto rating_calculation = [](uint& curr_rating, const uint height, const Coordinates&, CoordinatesSet&) {
-        if (height == max_height) {
-            curr_rating += 1;
-            return true;
-        }
-        return false;
-    };
+    const auto topographic_map = read_map_from_file(file_path);
+    const auto peaks = find_peaks(topographic_map);
+    auto scratch = make_traversal_scratch(topographic_map);
 
-    uint score_sum = 0;
-    uint rating_sum = 0;
-    for (const auto& coords : trailhead_coords) {
-        score_sum += calculate_trailhead_metric(topographic_map, coords, score_calculation);
-        rating_sum += calculate_trailhead_metric(topographic_map, coords, rating_calculation);
-    }
+    const auto score_sum = calculate_score_sum(topographic_map, peaks, scratch);
+    const auto rating_sum = calculate_rating_sum(topographic_map, peaks, scratch);
 
     std::cout << "Score: " << score_sum << '\n';
     std::cout << "Rating: " << rating_sum << '\n';
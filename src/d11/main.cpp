@@ -1,50 +1,212 @@
-#include <cmath>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace {
 using uint = unsigned int;
 using ulong = unsigned long;
 
-struct StoneBlinkHash {
-  [[nodiscard]] auto
-  operator()(const std::pair<ulong, uint> &blink_pair) const noexcept
-      -> std::size_t {
-    const auto h1 = std::hash<ulong>{}(blink_pair.first);
-    const auto h2 = std::hash<uint>{}(blink_pair.second);
+using Stones = std::vector<ulong>;
+using WideCount = unsigned __int128;
 
-    return h1 ^ h2 << 1;
-  }
+// Open-addressing value -> count table. Clearing keeps the slots allocated so
+// the two histograms can be swapped and reused on every blink.
+struct StoneHistogram {
+  std::vector<ulong> values;
+  std::vector<ulong> counts;
+  std::vector<std::uint8_t> occupied;
+  std::size_t size = 0;
 };
 
-using StoneBlinkMap =
-    std::unordered_map<std::pair<ulong, uint>, ulong, StoneBlinkHash>;
-using Stones = std::vector<ulong>;
+// Every stone value reachable from the input, with the one or two stones
+// each of them turns into after a blink.
+struct StoneTransitions {
+  std::vector<ulong> values;
+  std::vector<std::array<std::uint32_t, 2>> successors;
+  std::vector<std::uint8_t> num_successors;
+  std::vector<std::uint32_t> initial_stones;
+};
+
+// Exact counts, throwing once they no longer fit in 128 bits.
+struct ExactArithmetic {
+  using Count = WideCount;
+
+  [[nodiscard]] auto add(const Count a, const Count b) const -> Count;
+  [[nodiscard]] auto multiply(const Count a, const Count b) const -> Count;
+  [[nodiscard]] auto describe() const -> std::string;
+};
+
+// Counts reduced modulo a user-supplied prime.
+struct ModularArithmetic {
+  using Count = ulong;
+  ulong modulus;
+
+  [[nodiscard]] auto add(const Count a, const Count b) const -> Count;
+  [[nodiscard]] auto multiply(const Count a, const Count b) const -> Count;
+  [[nodiscard]] auto describe() const -> std::string;
+};
+
+template <typename Count> using CountMatrix = std::vector<std::vector<Count>>;
+
+// Read-only mapping of a file, left empty when the file does not exist yet.
+struct MappedFile {
+  const char *data = nullptr;
+  std::size_t size = 0;
+
+  explicit MappedFile(const std::string &file_path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  auto operator=(const MappedFile &) -> MappedFile & = delete;
+};
+
+// On-disk layout of the memo file: this header, the checkpoint blink counts,
+// the stone values in ascending order, then one row of counts per value.
+struct MemoHeader {
+  std::uint64_t magic;
+  std::uint64_t num_checkpoints;
+  std::uint64_t num_values;
+};
+
+constexpr auto memo_magic = std::uint64_t{0x314F4D454E4F5453}; // "STONEMO1"
+
+// Number of stones each value becomes after every checkpoint blink count,
+// either viewing a mapped memo file or owning freshly computed rows.
+struct MemoTable {
+  std::vector<ulong> checkpoints;
+  std::span<const ulong> values;
+  std::span<const ulong> counts;
+};
+
+struct MemoEntries {
+  std::vector<ulong> values;
+  std::vector<ulong> counts;
+};
+
+constexpr auto max_stone_digits = 20U;
+constexpr auto no_stone = ~ulong{0};
+
+constexpr auto powers_of_ten = [] {
+  std::array<ulong, max_stone_digits> powers{};
+  ulong power = 1;
+  for (auto &entry : powers) {
+    entry = power;
+    power *= 10;
+  }
+  return powers;
+}();
 
 // Prototypes //
 [[nodiscard]] auto read_stones_from_file(const std::string &file_path)
     -> Stones;
-void n_blinks_on_stone_collection(const Stones &stones, const uint n,
-                                  StoneBlinkMap &blink_map);
-[[nodiscard]] auto get_num_stones(const ulong &stone,
-                                  const uint remaining_blinks,
-                                  StoneBlinkMap &blink_map) -> ulong;
-[[nodiscard]] auto blink_stone(const ulong &stone) -> Stones;
-[[nodiscard]] auto get_num_digits(ulong stone) noexcept -> uint;
+[[nodiscard]] auto count_stones_with_memo(const Stones &stones,
+                                          const std::vector<ulong> &checkpoints,
+                                          const std::string &memo_path)
+    -> std::vector<ulong>;
+[[nodiscard]] auto open_memo_table(const MappedFile &memo_file,
+                                   const std::vector<ulong> &checkpoints)
+    -> MemoTable;
+[[nodiscard]] auto find_memo_row(const MemoTable &table, const ulong stone)
+    -> const ulong *;
+[[nodiscard]] auto expand_memo_table(const MemoTable &table,
+                                     const Stones &unseen_stones)
+    -> MemoEntries;
+[[nodiscard]] auto count_unseen_stone(const MemoTable &table, const ulong stone,
+                                      const ulong n, StoneHistogram &current,
+                                      StoneHistogram &next) -> ulong;
+auto blink_histogram(const StoneHistogram &stones, StoneHistogram &blinked)
+    -> void;
+auto add_stones(StoneHistogram &histogram, const ulong stone,
+                const ulong count) -> void;
+auto clear_histogram(StoneHistogram &histogram) -> void;
+auto grow_histogram(StoneHistogram &histogram) -> void;
+void write_memo_table(const std::string &memo_path,
+                      const std::vector<ulong> &checkpoints,
+                      const MemoEntries &entries);
+[[nodiscard]] auto find_stone_transitions(const Stones &stones)
+    -> StoneTransitions;
+template <typename Arithmetic>
+void count_stones_after_blinks(const StoneTransitions &transitions,
+                               const ulong n, const Arithmetic &arithmetic);
+template <typename Arithmetic>
+[[nodiscard]] auto step_stone_counts(const StoneTransitions &transitions,
+                                     const ulong n,
+                                     const Arithmetic &arithmetic) ->
+    typename Arithmetic::Count;
+template <typename Arithmetic>
+[[nodiscard]] auto square_stone_counts(const StoneTransitions &transitions,
+                                       const ulong n,
+                                       const Arithmetic &arithmetic) ->
+    typename Arithmetic::Count;
+template <typename Arithmetic>
+[[nodiscard]] auto
+multiply_matrices(const CountMatrix<typename Arithmetic::Count> &lhs,
+                  const CountMatrix<typename Arithmetic::Count> &rhs,
+                  const Arithmetic &arithmetic)
+    -> CountMatrix<typename Arithmetic::Count>;
+[[nodiscard]] auto blink_stone(const ulong stone) -> std::pair<ulong, ulong>;
+[[nodiscard]] auto get_num_digits(const ulong stone) noexcept -> uint;
 [[nodiscard]] auto split_stone(const ulong &stone, const uint len)
     -> std::pair<ulong, ulong>;
+[[nodiscard]] auto to_string(WideCount value) -> std::string;
 } // namespace
 
-auto main() -> int {
-  StoneBlinkMap blink_map;
-
+// With no arguments the puzzle's 25 and 75 blinks are answered from the memo
+// file, which is extended with any stones it has not seen yet.
+// Usage for larger counts: d11 <blinks> [prime modulus]
+// Exact counts outgrow 128 bits after roughly 200 blinks, beyond which a prime
+// modulus is required.
+auto main(const int argc, const char *argv[]) -> int {
   const auto file_path = std::string{"input.txt"};
   const auto stones = read_stones_from_file(file_path);
 
-  n_blinks_on_stone_collection(stones, 25, blink_map);
-  n_blinks_on_stone_collection(stones, 75, blink_map);
+  if (argc < 2) {
+    const auto memo_path = std::string{"stone_memo.bin"};
+    const auto checkpoints = std::vector<ulong>{25, 75};
+    const auto num_stones =
+        count_stones_with_memo(stones, checkpoints, memo_path);
+    for (std::size_t i = 0; i < checkpoints.size(); ++i) {
+      std::cout << "You have " << num_stones[i] << " stones after "
+                << checkpoints[i] << " blinks\n";
+    }
+    return 0;
+  }
+
+  const auto n = std::stoul(argv[1]);
+  const auto transitions = find_stone_transitions(stones);
+  if (argc > 2) {
+    const auto modulus = std::stoul(argv[2]);
+    if (modulus < 2) {
+      throw std::runtime_error("Modulus must be at least 2");
+    }
+    count_stones_after_blinks(transitions, n, ModularArithmetic{modulus});
+  } else {
+    try {
+      count_stones_after_blinks(transitions, n, ExactArithmetic{});
+    } catch (const std::overflow_error &error) {
+      std::cerr << error.what() << " after " << n
+                << " blinks; count them modulo a prime instead: d11 " << n
+                << " <prime modulus>\n";
+      return 1;
+    }
+  }
+  return 0;
 }
 
 // Function implementations //
@@ -63,73 +225,536 @@ namespace {
   return stones;
 }
 
-auto n_blinks_on_stone_collection(const Stones &stones, const uint n,
-                                  StoneBlinkMap &blink_map) -> void {
+[[nodiscard]] auto count_stones_with_memo(const Stones &stones,
+                                          const std::vector<ulong> &checkpoints,
+                                          const std::string &memo_path)
+    -> std::vector<ulong> {
+  auto num_stones = std::vector<ulong>(checkpoints.size());
+  MemoEntries expanded;
+  {
+    const auto memo_file = MappedFile(memo_path);
+    const auto table = open_memo_table(memo_file, checkpoints);
+
+    Stones unseen_stones;
+    for (const ulong &stone : stones) {
+      if (find_memo_row(table, stone) == nullptr) {
+        unseen_stones.push_back(stone);
+      }
+    }
+
+    if (unseen_stones.empty()) {
+      for (const ulong &stone : stones) {
+        const auto *row = find_memo_row(table, stone);
+        for (std::size_t i = 0; i < checkpoints.size(); ++i) {
+          num_stones[i] += row[i];
+        }
+      }
+      return num_stones;
+    }
+
+    expanded = expand_memo_table(table, unseen_stones);
+  }
+
+  write_memo_table(memo_path, checkpoints, expanded);
+
+  const auto table = MemoTable{checkpoints, expanded.values, expanded.counts};
+  for (const ulong &stone : stones) {
+    const auto *row = find_memo_row(table, stone);
+    for (std::size_t i = 0; i < checkpoints.size(); ++i) {
+      num_stones[i] += row[i];
+    }
+  }
+  return num_stones;
+}
+
+// Returns an empty table when the file is missing, truncated or was written
+// for different checkpoints, so it is simply rebuilt.
+[[nodiscard]] auto open_memo_table(const MappedFile &memo_file,
+                                   const std::vector<ulong> &checkpoints)
+    -> MemoTable {
+  auto table = MemoTable{checkpoints, {}, {}};
+  if (memo_file.size < sizeof(MemoHeader)) {
+    return table;
+  }
+
+  MemoHeader header;
+  std::memcpy(&header, memo_file.data, sizeof(header));
+  const auto num_words = memo_file.size / sizeof(ulong);
+  const auto header_words = sizeof(MemoHeader) / sizeof(ulong);
+  if (header.magic != memo_magic ||
+      header.num_checkpoints != checkpoints.size() ||
+      num_words != header_words + header.num_checkpoints +
+                       header.num_values * (1 + header.num_checkpoints)) {
+    return table;
+  }
+
+  const auto words = std::span<const ulong>(
+      reinterpret_cast<const ulong *>(memo_file.data), num_words);
+  const auto stored_checkpoints =
+      words.subspan(header_words, header.num_checkpoints);
+  if (!std::ranges::equal(stored_checkpoints, checkpoints)) {
+    return table;
+  }
+
+  const auto values_start = header_words + header.num_checkpoints;
+  table.values = words.subspan(values_start, header.num_values);
+  table.counts = words.subspan(values_start + header.num_values);
+  return table;
+}
+
+[[nodiscard]] auto find_memo_row(const MemoTable &table, const ulong stone)
+    -> const ulong * {
+  const auto entry = std::ranges::lower_bound(table.values, stone);
+  if (entry == table.values.end() || *entry != stone) {
+    return nullptr;
+  }
+
+  const auto index = static_cast<std::size_t>(entry - table.values.begin());
+  return table.counts.data() + index * table.checkpoints.size();
+}
+
+// Counts only the stones the table has not seen and merges their rows with the
+// stored ones, which are left as they are.
+[[nodiscard]] auto expand_memo_table(const MemoTable &table,
+                                     const Stones &unseen_stones)
+    -> MemoEntries {
+  const auto &checkpoints = table.checkpoints;
+  const auto num_checkpoints = checkpoints.size();
+
+  auto new_values = unseen_stones;
+  std::ranges::sort(new_values);
+  const auto [first_duplicate, last_duplicate] =
+      std::ranges::unique(new_values);
+  new_values.erase(first_duplicate, last_duplicate);
+
+  StoneHistogram current;
+  StoneHistogram next;
+  auto new_counts = std::vector<ulong>();
+  new_counts.reserve(new_values.size() * num_checkpoints);
+  for (const ulong &stone : new_values) {
+    for (const auto n : checkpoints) {
+      new_counts.push_back(count_unseen_stone(table, stone, n, current, next));
+    }
+  }
+
+  MemoEntries entries;
+  const auto append_row = [&](const ulong value, const ulong *row) {
+    entries.values.push_back(value);
+    entries.counts.insert(entries.counts.end(), row, row + num_checkpoints);
+  };
+
+  std::size_t stored = 0;
+  std::size_t fresh = 0;
+  while (stored < table.values.size() || fresh < new_values.size()) {
+    if (fresh == new_values.size() ||
+        (stored < table.values.size() &&
+         table.values[stored] < new_values[fresh])) {
+      append_row(table.values[stored],
+                 table.counts.data() + stored * num_checkpoints);
+      ++stored;
+    } else {
+      append_row(new_values[fresh],
+                 new_counts.data() + fresh * num_checkpoints);
+      ++fresh;
+    }
+  }
+
+  return entries;
+}
+
+// Advances a histogram of one stone blink by blink. Whenever the blinks left
+// equal a checkpoint, every stone the table knows is answered from its stored
+// row and dropped, so only values the table has not seen are expanded further.
+[[nodiscard]] auto count_unseen_stone(const MemoTable &table, const ulong stone,
+                                      const ulong n, StoneHistogram &current,
+                                      StoneHistogram &next) -> ulong {
+  const auto &checkpoints = table.checkpoints;
   ulong num_stones = 0;
+  clear_histogram(current);
+  add_stones(current, stone, 1);
+
+  for (ulong blink = 0; blink < n; ++blink) {
+    const auto checkpoint = std::ranges::find(checkpoints, n - blink);
+    if (checkpoint != checkpoints.end() && !table.values.empty()) {
+      const auto column =
+          static_cast<std::size_t>(checkpoint - checkpoints.begin());
+      clear_histogram(next);
+      for (std::size_t slot = 0; slot < current.values.size(); ++slot) {
+        if (!current.occupied[slot]) {
+          continue;
+        }
+
+        const auto value = current.values[slot];
+        const auto count = current.counts[slot];
+        if (const auto *row = find_memo_row(table, value); row != nullptr) {
+          num_stones += count * row[column];
+        } else {
+          add_stones(next, value, count);
+        }
+      }
+      std::swap(current, next);
+    }
+
+    blink_histogram(current, next);
+    std::swap(current, next);
+  }
+
+  for (std::size_t slot = 0; slot < current.values.size(); ++slot) {
+    if (current.occupied[slot]) {
+      num_stones += current.counts[slot];
+    }
+  }
+  return num_stones;
+}
+
+auto blink_histogram(const StoneHistogram &stones, StoneHistogram &blinked)
+    -> void {
+  clear_histogram(blinked);
+
+  for (std::size_t slot = 0; slot < stones.values.size(); ++slot) {
+    if (!stones.occupied[slot]) {
+      continue;
+    }
+
+    const auto count = stones.counts[slot];
+    const auto [first, second] = blink_stone(stones.values[slot]);
+    add_stones(blinked, first, count);
+    if (second != no_stone) {
+      add_stones(blinked, second, count);
+    }
+  }
+}
+
+auto add_stones(StoneHistogram &histogram, const ulong stone,
+                const ulong count) -> void {
+  // Keep the table at most half full so probe runs stay short.
+  if (2 * (histogram.size + 1) > histogram.values.size()) {
+    grow_histogram(histogram);
+  }
+
+  const auto mask = histogram.values.size() - 1;
+  auto slot = (stone * 0x9E3779B97F4A7C15UL >> 32) & mask;
+  while (histogram.occupied[slot] && histogram.values[slot] != stone) {
+    slot = (slot + 1) & mask;
+  }
+
+  if (!histogram.occupied[slot]) {
+    histogram.occupied[slot] = 1;
+    histogram.values[slot] = stone;
+    histogram.counts[slot] = 0;
+    ++histogram.size;
+  }
+  histogram.counts[slot] += count;
+}
+
+auto clear_histogram(StoneHistogram &histogram) -> void {
+  std::fill(histogram.occupied.begin(), histogram.occupied.end(), 0);
+  histogram.size = 0;
+}
+
+auto grow_histogram(StoneHistogram &histogram) -> void {
+  StoneHistogram grown;
+  const auto capacity =
+      histogram.values.empty() ? std::size_t{64} : 2 * histogram.values.size();
+  grown.values.resize(capacity);
+  grown.counts.resize(capacity);
+  grown.occupied.resize(capacity);
+
+  for (std::size_t slot = 0; slot < histogram.values.size(); ++slot) {
+    if (histogram.occupied[slot]) {
+      add_stones(grown, histogram.values[slot], histogram.counts[slot]);
+    }
+  }
+  histogram = std::move(grown);
+}
+
+// Writes beside the old file and renames over it, so a reader never maps a
+// half-written table.
+void write_memo_table(const std::string &memo_path,
+                      const std::vector<ulong> &checkpoints,
+                      const MemoEntries &entries) {
+  const auto temporary_path = memo_path + ".tmp";
+  {
+    auto file = std::ofstream(temporary_path, std::ios::binary);
+    const auto header =
+        MemoHeader{memo_magic, checkpoints.size(), entries.values.size()};
+    const auto write_words = [&](const void *data, const std::size_t bytes) {
+      file.write(static_cast<const char *>(data),
+                 static_cast<std::streamsize>(bytes));
+    };
+
+    write_words(&header, sizeof(header));
+    write_words(checkpoints.data(), checkpoints.size() * sizeof(ulong));
+    write_words(entries.values.data(), entries.values.size() * sizeof(ulong));
+    write_words(entries.counts.data(), entries.counts.size() * sizeof(ulong));
+    if (!file) {
+      throw std::runtime_error("Could not write " + temporary_path);
+    }
+  }
+
+  if (std::rename(temporary_path.c_str(), memo_path.c_str()) != 0) {
+    throw std::runtime_error("Could not replace " + memo_path);
+  }
+}
+
+MappedFile::MappedFile(const std::string &file_path) {
+  const auto fd = open(file_path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return;
+  }
+
+  struct stat file_info{};
+  fstat(fd, &file_info);
+  size = static_cast<std::size_t>(file_info.st_size);
+  if (size != 0) {
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("Could not map " + file_path);
+    }
+    data = static_cast<const char *>(mapping);
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data != nullptr) {
+    munmap(const_cast<char *>(data), size);
+  }
+}
+
+[[nodiscard]] auto find_stone_transitions(const Stones &stones)
+    -> StoneTransitions {
+  StoneTransitions transitions;
+  std::unordered_map<ulong, std::uint32_t> indices;
+  const auto intern = [&](const ulong stone) {
+    const auto [entry, inserted] = indices.try_emplace(
+        stone, static_cast<std::uint32_t>(transitions.values.size()));
+    if (inserted) {
+      transitions.values.push_back(stone);
+    }
+    return entry->second;
+  };
+
   for (const ulong &stone : stones) {
-    num_stones += get_num_stones(stone, n, blink_map);
+    transitions.initial_stones.push_back(intern(stone));
+  }
+
+  // Values are appended as they are discovered, so walking the list in order
+  // expands each one exactly once.
+  for (std::size_t i = 0; i < transitions.values.size(); ++i) {
+    const auto [first, second] = blink_stone(transitions.values[i]);
+    auto successors = std::array<std::uint32_t, 2>{intern(first), 0};
+    if (second != no_stone) {
+      successors[1] = intern(second);
+    }
+    transitions.successors.push_back(successors);
+    transitions.num_successors.push_back(second != no_stone ? 2 : 1);
+  }
+
+  return transitions;
+}
+
+template <typename Arithmetic>
+void count_stones_after_blinks(const StoneTransitions &transitions,
+                               const ulong n, const Arithmetic &arithmetic) {
+  // Stepping the sparse transitions costs about 2 * values per blink, while
+  // each dense squaring costs values^3, so squaring only pays off when the
+  // closed set is small compared to the number of blinks.
+  const auto num_values =
+      static_cast<long double>(transitions.values.size());
+  const auto stepping_cost = 2 * num_values * static_cast<long double>(n);
+  const auto squaring_cost =
+      num_values * num_values * num_values * std::bit_width(n);
+
+  const auto num_stones = squaring_cost < stepping_cost
+                              ? square_stone_counts(transitions, n, arithmetic)
+                              : step_stone_counts(transitions, n, arithmetic);
+
+  std::cout << "You have " << to_string(num_stones) << " stones"
+            << arithmetic.describe() << " after " << n << " blinks\n";
+}
+
+template <typename Arithmetic>
+[[nodiscard]] auto step_stone_counts(const StoneTransitions &transitions,
+                                     const ulong n,
+                                     const Arithmetic &arithmetic) ->
+    typename Arithmetic::Count {
+  using Count = typename Arithmetic::Count;
+  const auto num_values = transitions.values.size();
+
+  std::vector<Count> counts(num_values);
+  std::vector<Count> next(num_values);
+  for (const auto stone : transitions.initial_stones) {
+    counts[stone] = arithmetic.add(counts[stone], 1);
+  }
+
+  for (ulong blink = 0; blink < n; ++blink) {
+    std::fill(next.begin(), next.end(), Count{0});
+    for (std::size_t i = 0; i < num_values; ++i) {
+      for (std::uint8_t k = 0; k < transitions.num_successors[i]; ++k) {
+        const auto successor = transitions.successors[i][k];
+        next[successor] = arithmetic.add(next[successor], counts[i]);
+      }
+    }
+    std::swap(counts, next);
   }
 
-  std::cout << "You have " << num_stones << " stones after " << n
-            << " blinks\n";
+  Count num_stones = 0;
+  for (const auto count : counts) {
+    num_stones = arithmetic.add(num_stones, count);
+  }
+  return num_stones;
 }
 
-[[nodiscard]] auto get_num_stones(const ulong &stone,
-                                  const uint remaining_blinks,
-                                  StoneBlinkMap &blink_map) -> ulong {
-  if (remaining_blinks == 0) {
-    return 1;
+template <typename Arithmetic>
+[[nodiscard]] auto square_stone_counts(const StoneTransitions &transitions,
+                                       const ulong n,
+                                       const Arithmetic &arithmetic) ->
+    typename Arithmetic::Count {
+  using Count = typename Arithmetic::Count;
+  const auto num_values = transitions.values.size();
+
+  auto power = CountMatrix<Count>(num_values, std::vector<Count>(num_values));
+  for (std::size_t i = 0; i < num_values; ++i) {
+    for (std::uint8_t k = 0; k < transitions.num_successors[i]; ++k) {
+      auto &entry = power[i][transitions.successors[i][k]];
+      entry = arithmetic.add(entry, 1);
+    }
   }
 
-  const auto blink_key = std::make_pair(stone, remaining_blinks);
-  const auto blink_entry = blink_map.find(blink_key);
-  if (blink_entry != blink_map.cend()) {
-    return blink_entry->second;
+  // Row vector of initial stone counts, multiplied by transitions^n.
+  std::vector<Count> counts(num_values);
+  for (const auto stone : transitions.initial_stones) {
+    counts[stone] = arithmetic.add(counts[stone], 1);
   }
 
-  ulong total_stones = 0;
-  const Stones blinked_stones = blink_stone(stone);
-  for (const ulong &blinked_stone : blinked_stones) {
-    total_stones +=
-        get_num_stones(blinked_stone, remaining_blinks - 1, blink_map);
+  for (auto remaining = n; remaining != 0; remaining >>= 1) {
+    if (remaining & 1) {
+      std::vector<Count> next(num_values);
+      for (std::size_t i = 0; i < num_values; ++i) {
+        if (counts[i] == 0) {
+          continue;
+        }
+        for (std::size_t j = 0; j < num_values; ++j) {
+          next[j] = arithmetic.add(
+              next[j], arithmetic.multiply(counts[i], power[i][j]));
+        }
+      }
+      counts = std::move(next);
+    }
+    if (remaining > 1) {
+      power = multiply_matrices(power, power, arithmetic);
+    }
   }
 
-  blink_map.emplace(blink_key, total_stones);
-  return total_stones;
+  Count num_stones = 0;
+  for (const auto count : counts) {
+    num_stones = arithmetic.add(num_stones, count);
+  }
+  return num_stones;
 }
 
-[[nodiscard]] auto blink_stone(const ulong &stone) -> Stones {
+template <typename Arithmetic>
+[[nodiscard]] auto
+multiply_matrices(const CountMatrix<typename Arithmetic::Count> &lhs,
+                  const CountMatrix<typename Arithmetic::Count> &rhs,
+                  const Arithmetic &arithmetic)
+    -> CountMatrix<typename Arithmetic::Count> {
+  using Count = typename Arithmetic::Count;
+  const auto size = lhs.size();
+
+  auto product = CountMatrix<Count>(size, std::vector<Count>(size));
+  for (std::size_t i = 0; i < size; ++i) {
+    for (std::size_t k = 0; k < size; ++k) {
+      if (lhs[i][k] == 0) {
+        continue;
+      }
+      for (std::size_t j = 0; j < size; ++j) {
+        product[i][j] = arithmetic.add(
+            product[i][j], arithmetic.multiply(lhs[i][k], rhs[k][j]));
+      }
+    }
+  }
+  return product;
+}
+
+auto ExactArithmetic::add(const Count a, const Count b) const -> Count {
+  Count sum;
+  if (__builtin_add_overflow(a, b, &sum)) {
+    throw std::overflow_error("Stone count does not fit in 128 bits");
+  }
+  return sum;
+}
+
+auto ExactArithmetic::multiply(const Count a, const Count b) const -> Count {
+  Count product;
+  if (__builtin_mul_overflow(a, b, &product)) {
+    throw std::overflow_error("Stone count does not fit in 128 bits");
+  }
+  return product;
+}
+
+auto ExactArithmetic::describe() const -> std::string { return ""; }
+
+auto ModularArithmetic::add(const Count a, const Count b) const -> Count {
+  return static_cast<Count>((WideCount{a} + b) % modulus);
+}
+
+auto ModularArithmetic::multiply(const Count a, const Count b) const -> Count {
+  return static_cast<Count>(WideCount{a} * b % modulus);
+}
+
+auto ModularArithmetic::describe() const -> std::string {
+  return " (mod " + std::to_string(modulus) + ")";
+}
+
+// Returns the stones a single stone becomes, with no_stone in the second slot
+// when it does not split.
+[[nodiscard]] auto blink_stone(const ulong stone) -> std::pair<ulong, ulong> {
   if (stone == 0) {
-    return {1};
+    return {1, no_stone};
   }
 
   if (const auto digits = get_num_digits(stone); (digits & 1) == 0) {
-    const auto [first_half, second_half] = split_stone(stone, digits);
-    return {first_half, second_half};
+    return split_stone(stone, digits);
   }
 
-  return {stone * 2024};
+  ulong multiplied;
+  if (__builtin_mul_overflow(stone, ulong{2024}, &multiplied) ||
+      multiplied == no_stone) {
+    throw std::runtime_error("Stone value does not fit in 64 bits");
+  }
+  return {multiplied, no_stone};
 }
 
-[[nodiscard]] auto get_num_digits(ulong stone) noexcept -> uint {
-  uint digits = 0;
-  while (stone != 0) {
+[[nodiscard]] auto get_num_digits(const ulong stone) noexcept -> uint {
+  uint digits = 1;
+  while (digits < max_stone_digits && stone >= powers_of_ten[digits]) {
     ++digits;
-    stone /= 10;
   }
   return digits;
 }
 
 [[nodiscard]] auto split_stone(const ulong &stone, const uint len)
     -> std::pair<ulong, ulong> {
-  ulong first_half = 0;
-  const auto exponent = len / 2;
-  const auto divisor = static_cast<ulong>(std::powl(10, exponent));
+  const auto divisor = powers_of_ten[len / 2];
 
   // Split the number into two parts.
-  first_half = stone / divisor;
-  ulong second_half = stone % divisor;
+  const auto first_half = stone / divisor;
+  const auto second_half = stone % divisor;
 
   return {first_half, second_half};
 }
+
+[[nodiscard]] auto to_string(WideCount value) -> std::string {
+  std::string digits;
+  do {
+    digits.push_back(static_cast<char>('0' + static_cast<int>(value % 10)));
+    value /= 10;
+  } while (value != 0);
+
+  std::ranges::reverse(digits);
+  return digits;
+}
 } // namespace
@@ -1,85 +1,63 @@
-#include <array>
 #include <fstream>
 #include <iostream>
-#include <queue>
+#include <stdexcept>
 #include <string>
-#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace {
 using uint = unsigned int;
-struct Region {
-  const uint perimeter;
-  const uint area;
-  const uint sides;
-};
-
-using Direction = std::pair<int, int>;
-
-struct DirectionHash {
-  [[nodiscard]] auto operator()(const Direction &direction) const noexcept
-      -> std::size_t {
-    const auto h1 = std::hash<int>()(direction.first);
-    const auto h2 = std::hash<int>()(direction.second);
+using ulong = unsigned long;
 
-    return h1 ^ h2 << 1;
-  }
+struct Region {
+  ulong perimeter = 0;
+  ulong area = 0;
+  ulong sides = 0;
 };
 
-struct Coordinates {
-  const int x;
-  const int y;
-
-  Coordinates(const int x, const int y) : x(x), y(y) {}
-  Coordinates(const std::size_t &x, const std::size_t &y) : x(x), y(y) {}
-
-  [[nodiscard]] auto operator==(const Coordinates &rhs) const -> bool = default;
-  [[nodiscard]] auto operator+(const Direction &direction) const noexcept
-      -> Coordinates {
-    const auto new_x = this->x + direction.first;
-    const auto new_y = this->y + direction.second;
-
-    return {new_x, new_y};
-  }
+struct FencePrices {
+  ulong full = 0;
+  ulong discounted = 0;
 };
 
-using DirectionSet = std::unordered_set<Direction, DirectionHash>;
+// Outside the garden, never a plant type, so borders need no bounds checks.
+constexpr char no_plant = '\0';
 
-constexpr Direction directions[4] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
-constexpr Direction adjacent_directions[4][2] = {
-    {{1, 0}, {0, 1}}, {{0, 1}, {-1, 0}}, {{-1, 0}, {0, -1}}, {{0, -1}, {1, 0}}};
+// One row of plants padded with no_plant on both sides, so column x of the
+// garden is at index x + 1.
+using PlotRow = std::vector<char>;
 
-struct Plot {
-  char plant_type;
-  bool visited = false;
+// Region labels of the previous and current rows, joined by a union-find whose
+// roots carry each region's running totals. Labels are renumbered after every
+// row, so memory depends only on the garden width.
+struct RegionLabels {
+  std::vector<uint> previous_row;
+  std::vector<uint> current_row;
+  std::vector<uint> parents;
+  std::vector<Region> regions;
 };
 
-constexpr std::size_t plot_width = 140;
-constexpr std::size_t plot_height = 140;
-using PlotArray = std::array<std::array<Plot, plot_width>, plot_height>;
-
 // Prototypes
-[[nodiscard]] auto read_plots_from_file(const std::string &rel_file_path)
-    -> PlotArray;
-[[nodiscard]] auto plot_array_to_regions(PlotArray &plot_array)
-    -> std::vector<Region>;
-[[nodiscard]] auto new_plot_region(PlotArray &plot_array,
-                                   const Coordinates &start_coords,
-                                   const char plant_type) -> Region;
+[[nodiscard]] auto price_garden_from_file(const std::string &rel_file_path)
+    -> FencePrices;
+[[nodiscard]] auto to_plot_row(const std::string &line, const std::size_t width)
+    -> PlotRow;
+auto label_row(const PlotRow &previous_plots, const PlotRow &current_plots,
+               RegionLabels &labels) -> void;
+auto tally_windows(const PlotRow &previous_plots, const PlotRow &current_plots,
+                   RegionLabels &labels) -> void;
+auto close_finished_regions(const PlotRow &current_plots, RegionLabels &labels,
+                            FencePrices &prices) -> void;
+[[nodiscard]] auto new_label(RegionLabels &labels) -> uint;
+[[nodiscard]] auto find_root(RegionLabels &labels, uint label) -> uint;
+auto merge_labels(RegionLabels &labels, const uint lhs, const uint rhs) -> void;
 } // namespace
 
 auto main() -> int {
   const std::string file_path = "input.txt";
-  PlotArray plot_array = read_plots_from_file(file_path);
-
-  const std::vector<Region> regions = plot_array_to_regions(plot_array);
+  const auto [fencing_price, discounted_fence_price] =
+      price_garden_from_file(file_path);
 
-  uint fencing_price = 0;
-  uint discounted_fence_price = 0;
-  for (const auto &[perimeter, area, sides] : regions) {
-    fencing_price += perimeter * area;
-    discounted_fence_price += area * sides;
-  }
   std::cout << "Fence price without discount: " << fencing_price << '\n';
   std::cout << "Fence price with discount: " << discounted_fence_price << '\n';
 
@@ -87,113 +65,200 @@ auto main() -> int {
 }
 
 namespace {
-[[nodiscard]] auto read_plots_from_file(const std::string &rel_file_path)
-    -> PlotArray {
-  PlotArray plot_array;
+// Streams the garden one row at a time. Each row is labelled against the one
+// above it, then every 2x2 window spanning the two rows adds its share of area,
+// perimeter and corners, and regions with no plots in the new row are priced.
+[[nodiscard]] auto price_garden_from_file(const std::string &rel_file_path)
+    -> FencePrices {
   auto file = std::ifstream(rel_file_path);
-
-  std::size_t row = 0;
-  for (std::string line; std::getline(file, line); ++row) {
-    std::size_t column = 0;
-    for (const auto c : line) {
-      plot_array[row][column] = Plot{c};
-      ++column;
+  FencePrices prices;
+  RegionLabels labels;
+
+  std::size_t width = 0;
+  PlotRow previous_plots;
+  for (std::string line; std::getline(file, line);) {
+    if (line.empty()) {
+      continue;
+    }
+    if (previous_plots.empty()) {
+      width = line.size();
+      previous_plots.assign(width + 2, no_plant);
+      labels.previous_row.assign(width, 0);
+      labels.current_row.assign(width, 0);
     }
+
+    const auto current_plots = to_plot_row(line, width);
+    label_row(previous_plots, current_plots, labels);
+    tally_windows(previous_plots, current_plots, labels);
+    close_finished_regions(current_plots, labels, prices);
+    previous_plots = current_plots;
   }
 
-  return plot_array;
-}
+  // A row of no_plant below the garden closes its bottom border.
+  if (not previous_plots.empty()) {
+    const auto beyond_garden = PlotRow(width + 2, no_plant);
+    label_row(previous_plots, beyond_garden, labels);
+    tally_windows(previous_plots, beyond_garden, labels);
+    close_finished_regions(beyond_garden, labels, prices);
+  }
 
-[[nodiscard]] auto plot_array_to_regions(PlotArray &plot_array)
-    -> std::vector<Region> {
-  std::vector<Region> regions;
+  return prices;
+}
 
-  // Find first plant of given type and group bordering plants into region
-  for (std::size_t row = 0; row < plot_width; ++row) {
-    for (std::size_t col = 0; col < plot_height; ++col) {
-      const auto curr_coords = Coordinates{col, row};
-      auto &[plant_type, visited] = plot_array[row][col];
-      if (visited) {
-        continue;
-      }
+[[nodiscard]] auto to_plot_row(const std::string &line, const std::size_t width)
+    -> PlotRow {
+  if (line.size() != width) {
+    throw std::runtime_error("Garden rows must all have the same width");
+  }
 
-      visited = true;
-      const Region new_region =
-          new_plot_region(plot_array, curr_coords, plant_type);
-      regions.push_back(new_region);
+  auto plots = PlotRow(width + 2, no_plant);
+  for (std::size_t column = 0; column < width; ++column) {
+    if (line[column] == no_plant) {
+      throw std::runtime_error("Garden contains a NUL plot");
     }
+    plots[column + 1] = line[column];
   }
-
-  return regions;
+  return plots;
 }
 
-[[nodiscard]] auto new_plot_region(PlotArray &plot_array,
-                                   const Coordinates &start_coords,
-                                   const char plant_type) -> Region {
-  uint area = 0;
-  uint perimeter = 0;
-  uint sides = 0;
-
-  const auto is_empty_coordinate = [&plot_array,
-                                    &plant_type](const Coordinates &coords) {
-    const auto [x, y] = coords;
-    if (x < 0 or x >= plot_width or y < 0 or y >= plot_height) {
-      return true;
+// First pass: a plot joins the region on its left or above it, merging the
+// two when both match.
+auto label_row(const PlotRow &previous_plots, const PlotRow &current_plots,
+               RegionLabels &labels) -> void {
+  const auto width = labels.current_row.size();
+  for (std::size_t column = 0; column < width; ++column) {
+    const auto plant_type = current_plots[column + 1];
+    if (plant_type == no_plant) {
+      continue;
+    }
+
+    const auto joins_left = current_plots[column] == plant_type;
+    const auto joins_above = previous_plots[column + 1] == plant_type;
+    auto &label = labels.current_row[column];
+    if (joins_left) {
+      label = labels.current_row[column - 1];
+      if (joins_above) {
+        merge_labels(labels, label, labels.previous_row[column]);
+      }
+    } else if (joins_above) {
+      label = labels.previous_row[column];
+    } else {
+      label = new_label(labels);
     }
+  }
+}
 
-    auto &[adjacent_plant_type, visited] = plot_array[y][x];
-    return adjacent_plant_type != plant_type;
+// Each window a b / c d adds the left and top edges of d, and a corner for any
+// plot whose two window neighbours both differ from it, or both match it while
+// the diagonal one differs.
+auto tally_windows(const PlotRow &previous_plots, const PlotRow &current_plots,
+                   RegionLabels &labels) -> void {
+  const auto width = labels.current_row.size();
+  const auto add = [&labels](const uint label, const ulong area,
+                             const ulong edges, const bool corner) {
+    auto &region = labels.regions[find_root(labels, label)];
+    region.area += area;
+    region.perimeter += edges;
+    region.sides += corner;
+  };
+  const auto is_corner = [](const char plot, const char horizontal,
+                            const char vertical, const char diagonal) {
+    return (plot != horizontal and plot != vertical) or
+           (plot == horizontal and plot == vertical and plot != diagonal);
   };
 
-  // Perform BFS to find region
-  const auto [start_x, start_y] = start_coords;
-  plot_array[start_y][start_x].visited = true;
-  auto plot_queue = std::queue<Coordinates>{{start_coords}};
-  while (not plot_queue.empty()) {
-    ++area;
-
-    const auto curr_coords = plot_queue.front();
-    plot_queue.pop();
-
-    // Check perimeter and queue next plots
-    const auto [curr_x, curr_y] = curr_coords;
-    for (const auto &direction : directions) {
-      const auto new_coords = curr_coords + direction;
-      if (is_empty_coordinate(new_coords)) {
-        ++perimeter;
-        continue;
-      }
+  for (std::size_t column = 0; column <= width; ++column) {
+    const auto a = previous_plots[column];
+    const auto b = previous_plots[column + 1];
+    const auto c = current_plots[column];
+    const auto d = current_plots[column + 1];
 
-      const auto [new_x, new_y] = new_coords;
-      auto &visited = plot_array[new_y][new_x].visited;
-      if (visited) {
-        continue;
-      }
-      visited = true;
-      plot_queue.push(new_coords);
+    if (a != no_plant) {
+      add(labels.previous_row[column - 1], 0, 0, is_corner(a, b, c, d));
+    }
+    if (b != no_plant) {
+      add(labels.previous_row[column], 0, b != d, is_corner(b, a, d, c));
+    }
+    if (c != no_plant) {
+      add(labels.current_row[column - 1], 0, c != d, is_corner(c, d, a, b));
     }
+    if (d != no_plant) {
+      const auto edges = ulong{c != d} + ulong{b != d};
+      add(labels.current_row[column], 1, edges, is_corner(d, c, b, a));
+    }
+  }
+}
 
-    // Check for corners (and hence edges)
-    for (const auto &direction_pair : adjacent_directions) {
-      const auto &[direction1, direction2] = direction_pair;
-      const auto coord1 = curr_coords + direction1;
-      const auto coord2 = curr_coords + direction2;
-
-      const auto coord1_empty = is_empty_coordinate(coord1);
-      const auto coord2_empty = is_empty_coordinate(coord2);
-      if (coord1_empty and coord2_empty) {
-        ++sides;
-        continue;
-      }
+// Prices every region with no plot in the current row, then renumbers the
+// surviving roots so the next row starts from labels 0..k-1.
+auto close_finished_regions(const PlotRow &current_plots, RegionLabels &labels,
+                            FencePrices &prices) -> void {
+  constexpr auto unassigned = ~uint{0};
+  const auto width = labels.current_row.size();
+  auto renumbered = std::vector<uint>(labels.parents.size(), unassigned);
+  std::vector<Region> surviving_regions;
+
+  for (std::size_t column = 0; column < width; ++column) {
+    if (current_plots[column + 1] == no_plant) {
+      continue;
+    }
 
-      const auto corner_coord = curr_coords + direction1 + direction2;
-      if (not coord1_empty and not coord2_empty and
-          is_empty_coordinate(corner_coord)) {
-        ++sides;
-      }
+    const auto root = find_root(labels, labels.current_row[column]);
+    if (renumbered[root] == unassigned) {
+      renumbered[root] = static_cast<uint>(surviving_regions.size());
+      surviving_regions.push_back(labels.regions[root]);
     }
+    labels.previous_row[column] = renumbered[root];
+  }
+
+  for (uint label = 0; label < labels.parents.size(); ++label) {
+    if (labels.parents[label] == label and renumbered[label] == unassigned) {
+      const auto &[perimeter, area, sides] = labels.regions[label];
+      prices.full += area * perimeter;
+      prices.discounted += area * sides;
+    }
+  }
+
+  labels.regions = std::move(surviving_regions);
+  labels.parents.resize(labels.regions.size());
+  for (uint label = 0; label < labels.parents.size(); ++label) {
+    labels.parents[label] = label;
+  }
+}
+
+[[nodiscard]] auto new_label(RegionLabels &labels) -> uint {
+  const auto label = static_cast<uint>(labels.parents.size());
+  labels.parents.push_back(label);
+  labels.regions.emplace_back();
+  return label;
+}
+
+[[nodiscard]] auto find_root(RegionLabels &labels, uint label) -> uint {
+  while (labels.parents[label] != label) {
+    labels.parents[label] = labels.parents[labels.parents[label]];
+    label = labels.parents[label];
+  }
+  return label;
+}
+
+// The lower label becomes the root so regions carried over from the previous
+// row keep their totals in place.
+auto merge_labels(RegionLabels &labels, const uint lhs, const uint rhs)
+    -> void {
+  auto lhs_root = find_root(labels, lhs);
+  auto rhs_root = find_root(labels, rhs);
+  if (lhs_root == rhs_root) {
+    return;
+  }
+  if (rhs_root < lhs_root) {
+    std::swap(lhs_root, rhs_root);
   }
 
-  return {perimeter, area, sides};
+  auto &root_region = labels.regions[lhs_root];
+  const auto &merged_region = labels.regions[rhs_root];
+  root_region.perimeter += merged_region.perimeter;
+  root_region.area += merged_region.area;
+  root_region.sides += merged_region.sides;
+  labels.parents[rhs_root] = lhs_root;
 }
 } // namespace